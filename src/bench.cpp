@@ -0,0 +1,282 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "profiler.h"
+#include "rng.h"
+#include "save.h"
+#include "sim.h"
+#include "vm.h"
+
+// --- БЕНЧМАРКИ ЯДРА ---
+// Микро: ход VM по классам геномов, раскраска снимка, сохранение/загрузка.
+// Макро: UpdateWorld на разных размерах мира, плотностях и числе потоков.
+// Все сценарии строятся из фиксированного seed; макро-прогоны идут фиксированное число тиков,
+// так что мир в конце одинаков и его контрольная сумма лежит в label - по ней видно,
+// что сравниваются одинаковые прогоны. Сравнение между коммитами и устройствами:
+//   bench --benchmark_out=bench.json --benchmark_out_format=json
+//   compare.py benchmarks old.json new.json   (tools/ из Google Benchmark)
+
+const unsigned BENCH_SEED = 12345;
+const int UPDATE_TICKS = 100; // Тиков в одном макро-прогоне
+
+enum GenomeClass {
+    GENOME_RANDOM,   // Как при генерации мира
+    GENOME_PHOTO,    // Только фотосинтез
+    GENOME_HUNTER,   // Поворот + движение/атака
+    GENOME_DIVIDER,  // Фотосинтез + деление
+    GENOME_SENSE,    // Запросы к окрестности + движение
+    GENOME_IDLE,     // Пустые команды до лимита хода
+    GENOME_CLASS_COUNT
+};
+
+const char* const GENOME_CLASS_NAMES[GENOME_CLASS_COUNT] = { "random", "photo", "hunter", "divider", "sense", "idle" };
+
+static void FillGenome(GenomeClass cls, CounterRng& rng, unsigned char* genome) {
+    static const unsigned char HUNTER[] = { CMD_TURN_FIRST + 1, CMD_MOVE, CMD_EAT, CMD_PHOTOSYNTHESIS };
+    static const unsigned char DIVIDER[] = { CMD_PHOTOSYNTHESIS, CMD_PHOTOSYNTHESIS, CMD_DIVIDE, CMD_TURN_FIRST + 3 };
+    static const unsigned char SENSE[] = { CMD_SENSE_ORGANIC, CMD_MOVE, CMD_SENSE_CROWD, 2, CMD_SENSE_ENERGY, 1, CMD_EAT };
+    for (int g = 0; g < genomeSize; g++) {
+        switch (cls) {
+        case GENOME_PHOTO: genome[g] = CMD_PHOTOSYNTHESIS; break;
+        case GENOME_HUNTER: genome[g] = HUNTER[g % 4]; break;
+        case GENOME_DIVIDER: genome[g] = DIVIDER[g % 4]; break;
+        case GENOME_SENSE: genome[g] = SENSE[g % 7]; break;
+        case GENOME_IDLE: genome[g] = 9; break;
+        default: genome[g] = (unsigned char)rng.Next(); break;
+        }
+    }
+}
+
+// Мир w x h, боты в ~density% клеток
+static void SeedWorld(int w, int h, int density, GenomeClass cls) {
+    config.worldW = w;
+    config.worldH = h;
+    config.seed = BENCH_SEED;
+    ClampConfig(config);
+    AllocateWorld();
+    const uint32_t cellKey = RngKey(worldSeed, 0, RNG_STREAM_INIT_CELL);
+    const uint32_t genomeKey = RngKey(worldSeed, 0, RNG_STREAM_INIT_GENOME);
+    for (int i = 0; i < world.cells; i++) {
+        uint32_t r = CellRandom(cellKey, (uint32_t)i);
+        worldGrid.organic[i] = (r & 0xFF) % 50;
+        if ((int)((r >> 8) % 100) >= density) continue;
+        worldGrid.alive[i] = 1;
+        worldGrid.energy[i] = 500;
+        worldGrid.born[i] = worldTick;
+        worldGrid.dir[i] = (r >> 16) % 8;
+        unsigned char genome[MAX_GENOME_SIZE];
+        CounterRng genomeRng(genomeKey, (uint32_t)i);
+        FillGenome(cls, genomeRng, genome);
+        worldGrid.genome[i] = genomePool.Intern(genome);
+    }
+    RebuildBotLists();
+}
+
+static std::string ChecksumLabel() {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "checksum %016llx", (unsigned long long)WorldChecksum());
+    return buf;
+}
+
+// --- VM ---
+// Один ход всех ботов мира 256 x 256 (плотность 50%) без применения: мир не меняется
+static void BM_ProcessBot(benchmark::State& state, GenomeClass cls, VmMode mode) {
+    workerPool.Resize(1);
+    SeedWorld(256, 256, 50, cls);
+    std::vector<int> bots;
+    for (int i = 0; i < world.cells; i++) {
+        if (worldGrid.alive[i]) bots.push_back(i);
+    }
+    std::vector<BotIntent> intents(bots.size());
+    vmMode = mode;
+    for (auto _ : state) {
+        RunBots(bots.data(), (int)bots.size(), worldGrid, intents.data());
+        benchmark::DoNotOptimize(intents.data());
+        benchmark::ClobberMemory();
+    }
+    vmMode = VM_MODE_SCALAR;
+    state.SetItemsProcessed(state.iterations() * (int64_t)bots.size());
+}
+
+// Ядро пресета против общего ядра (RuntimeRules) на тех же числах: цена правил во время выполнения
+static void BM_RulesKernel(benchmark::State& state, int preset, bool bounded, bool generic) {
+    config.rules = RulesPreset(preset, bounded);
+    config.genericRules = generic;
+    BM_ProcessBot(state, GENOME_RANDOM, VM_MODE_SIMD);
+    state.SetLabel(VmRulesKernel());
+    config.rules = SimRules();
+    config.genericRules = false;
+}
+
+// --- ТИК ---
+static void BM_UpdateWorld(benchmark::State& state, int w, int h, int density, int threads) {
+    workerPool.Resize(threads);
+    SeedWorld(w, h, density, GENOME_RANDOM);
+    for (auto _ : state) UpdateWorld();
+    state.SetItemsProcessed(state.iterations() * (int64_t)world.cells);
+    state.counters["alive"] = (double)aliveCount.load();
+    state.SetLabel(ChecksumLabel());
+}
+
+// --- СНИМОК И ОТРИСОВКА ---
+// Полный: каждый раз свежий слот, все блоки копируются. Инкрементальный: тик (вне замера) и снимок
+// в тот же слот - как в потоке симуляции; camera - то же, но видна только часть мира (зум на телефоне).
+static void BM_SnapshotFull(benchmark::State& state) {
+    workerPool.Resize(0);
+    SeedWorld(1024, 1024, 20, GENOME_RANDOM);
+    for (auto _ : state) {
+        SimSnapshot snap;
+        BuildSnapshot(snap);
+        benchmark::DoNotOptimize(snap.cells.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)world.cells * 2);
+}
+
+static void BM_SnapshotIncremental(benchmark::State& state, SnapshotRect visible) {
+    workerPool.Resize(0);
+    SeedWorld(1024, 1024, 20, GENOME_RANDOM);
+    snapshotVisible = visible;
+    SimSnapshot snap;
+    BuildSnapshot(snap);
+    for (auto _ : state) {
+        state.PauseTiming();
+        UpdateWorld();
+        state.ResumeTiming();
+        BuildSnapshot(snap);
+        benchmark::DoNotOptimize(snap.cells.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)world.cells * 2);
+    snapshotVisible = SnapshotRect();
+}
+
+struct BenchPixel {
+    unsigned char r, g, b, a;
+};
+
+// CPU-раскраска уровня 0 в DrawWorld (палитры - произвольные, важен только доступ)
+static void BM_PackPixels(benchmark::State& state, SnapshotView view) {
+    workerPool.Resize(0);
+    SeedWorld(1024, 1024, 20, GENOME_RANDOM);
+    snapshotView = view;
+    SimSnapshot snap;
+    BuildSnapshot(snap);
+    snapshotView = VIEW_ORGANIC;
+    BenchPixel organic[256], values[256], botColors[2];
+    for (int v = 0; v < 256; v++) {
+        organic[v] = { (unsigned char)v, (unsigned char)(v / 2), 0, 255 };
+        values[v] = { (unsigned char)v, 0, (unsigned char)(255 - v), 255 };
+    }
+    botColors[BOT_COLOR_GREEN] = { 0, 228, 48, 255 };
+    botColors[BOT_COLOR_RED] = { 150, 0, 0, 255 };
+    std::vector<BenchPixel> pixels(world.cells);
+    const BenchPixel* bots = view == VIEW_ORGANIC ? nullptr : values;
+    for (auto _ : state) {
+        PackCellPixels(snap.cells.data(), 0, world.cells, organic, bots, botColors, pixels.data());
+        benchmark::DoNotOptimize(pixels.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)world.cells);
+}
+
+// --- СОХРАНЕНИЯ ---
+const char* const BENCH_SAVE_PATH = "alife_bench.sav"; // В рабочем каталоге, удаляется после замера
+
+static void BM_SaveWorld(benchmark::State& state, bool compress) {
+    if (compress && !SaveCompressionAvailable()) {
+        state.SkipWithError("built without zstd");
+        return;
+    }
+    workerPool.Resize(0);
+    SeedWorld(1024, 1024, 20, GENOME_RANDOM);
+    for (auto _ : state) {
+        if (!SaveWorld(BENCH_SAVE_PATH, compress)) {
+            state.SkipWithError("save failed");
+            break;
+        }
+    }
+    std::remove(BENCH_SAVE_PATH);
+}
+
+static void BM_LoadWorld(benchmark::State& state) {
+    workerPool.Resize(0);
+    SeedWorld(1024, 1024, 20, GENOME_RANDOM);
+    if (!SaveWorld(BENCH_SAVE_PATH, false)) {
+        state.SkipWithError("save failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (!LoadWorld(BENCH_SAVE_PATH)) {
+            state.SkipWithError("load failed");
+            break;
+        }
+    }
+    std::remove(BENCH_SAVE_PATH);
+}
+
+int main(int argc, char** argv) {
+    const char* const VM_NAMES[] = { "scalar", "simd" };
+    for (int c = 0; c < GENOME_CLASS_COUNT; c++) {
+        for (int m = 0; m < 2; m++) {
+            std::string name = std::string("ProcessBot/") + GENOME_CLASS_NAMES[c] + "/" + VM_NAMES[m];
+            benchmark::RegisterBenchmark(name.c_str(), BM_ProcessBot, (GenomeClass)c, m ? VM_MODE_SIMD : VM_MODE_SCALAR);
+        }
+    }
+
+    for (int preset = 0; preset < RULES_PRESET_COUNT; preset++) {
+        for (int bounded = 0; bounded < 2; bounded++) {
+            for (int generic = 0; generic < 2; generic++) {
+                std::string name = std::string("RulesKernel/") + RULES_PRESET_NAMES[preset] + (bounded ? "-bounded" : "") +
+                                   (generic ? "/generic" : "/preset");
+                benchmark::RegisterBenchmark(name.c_str(), BM_RulesKernel, preset, bounded != 0, generic != 0);
+            }
+        }
+    }
+
+    // Плотность 20% - как у InitWorld; 5% - почти пустой мир, 60% - давка
+    const int SIZES[][2] = { { 256, 128 }, { 1024, 1024 } };
+    const int DENSITIES[] = { 5, 20, 60 };
+    const int hardware = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threads = { 1 };
+    if (hardware >= 4) threads.push_back(4);
+    if (hardware > 4) threads.push_back(hardware);
+    for (const auto& size : SIZES) {
+        for (int density : DENSITIES) {
+            for (int t : threads) {
+                char name[96];
+                std::snprintf(name, sizeof(name), "UpdateWorld/%dx%d/density:%d/threads:%d", size[0], size[1], density, t);
+                benchmark::RegisterBenchmark(name, BM_UpdateWorld, size[0], size[1], density, t)
+                    ->Iterations(UPDATE_TICKS)
+                    ->UseRealTime()
+                    ->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+
+    benchmark::RegisterBenchmark("Snapshot/full", BM_SnapshotFull)->UseRealTime()->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Snapshot/incremental", BM_SnapshotIncremental, SnapshotRect())
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Snapshot/camera", BM_SnapshotIncremental, SnapshotRect{ 384, 384, 640, 528 })
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("PackPixels/organic", BM_PackPixels, VIEW_ORGANIC)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("PackPixels/energy", BM_PackPixels, VIEW_ENERGY)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Save/raw", BM_SaveWorld, false)->UseRealTime()->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Save/zstd", BM_SaveWorld, true)->UseRealTime()->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Load", BM_LoadWorld)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    // Устройство и сборка - в шапке JSON, рядом с результатами
+    benchmark::AddCustomContext("device", DeviceDescription());
+    benchmark::AddCustomContext("vm_simd_kernel", VmSimdKernel());
+    benchmark::AddCustomContext("seed", std::to_string(BENCH_SEED));
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
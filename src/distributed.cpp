@@ -0,0 +1,558 @@
+#include "distributed.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include "profiler.h"
+#include "sim.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+static bool Fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+bool ParseDistHosts(const char* list, std::vector<std::string>& hosts) {
+    hosts.clear();
+    std::string s = list ? list : "";
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+        std::string host = s.substr(start, end - start);
+        if (host.find(':') == std::string::npos) return false;
+        hosts.push_back(host);
+        start = end + 1;
+    }
+    return !hosts.empty();
+}
+
+// --- УПАКОВКА СТРОК ---
+// Блок строк [r0, r0 + rows) локального мира: органика и занятость всех клеток,
+// затем по живой клетке подряд - энергия, ip, dir, цвет, тик рождения и геном.
+// Геном - его байты (сборка мира) или 64-битный отпечаток (гало, см. ниже).
+// Порядок байт - родной: узлы кольца считаются машинами одной архитектуры.
+static void Put(std::vector<unsigned char>& out, const void* data, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)data;
+    out.insert(out.end(), p, p + bytes);
+}
+
+const size_t BOT_STATE_BYTES = sizeof(int) + 3 + sizeof(unsigned); // Запись бота до генома
+
+// bots (если есть) - клетки упакованных ботов по порядку: по номеру в блоке отправитель досылает геном
+static void PackRows(int r0, int rows, bool prints, std::vector<unsigned char>& out, std::vector<int>* bots = nullptr) {
+    const WorldBuffer& grid = worldGrid;
+    const size_t first = (size_t)r0 * world.w, n = (size_t)rows * world.w;
+    Put(out, &grid.organic[first], n * sizeof(int));
+    Put(out, &grid.alive[first], n);
+    if (bots) bots->clear();
+    for (size_t i = first; i < first + n; i++) {
+        if (!grid.alive[i]) continue;
+        Put(out, &grid.energy[i], sizeof(int));
+        const unsigned char state[3] = { grid.ip[i], grid.dir[i], grid.color[i] };
+        Put(out, state, sizeof(state));
+        Put(out, &grid.born[i], sizeof(unsigned));
+        if (prints) Put(out, &genomePool.print[grid.genome[i]], sizeof(uint64_t));
+        else Put(out, genomePool.Get(grid.genome[i]), genomeSize);
+        if (bots) bots->push_back((int)i);
+    }
+}
+
+// Что запись строк поменяла в мире (для RefreshRows)
+struct RowsDelta {
+    int alive = 0;
+    long long organic = 0;
+};
+
+// Обратная запись. slotOf(genome) - слот по полю генома записи бота, уже с +1 ссылкой.
+// Слоты прежних ботов этих строк уходят в released: их отпускают, когда новые ссылки взяты во всех блоках
+template <class SlotOf>
+static bool UnpackRows(const unsigned char* data, size_t bytes, int r0, int rows, size_t genomeBytes, SlotOf slotOf,
+                       RowsDelta& delta, std::vector<int>& released) {
+    WorldBuffer& grid = worldGrid;
+    const size_t first = (size_t)r0 * world.w, n = (size_t)rows * world.w;
+    const size_t botBytes = BOT_STATE_BYTES + genomeBytes;
+    if (bytes < n * (sizeof(int) + 1)) return false;
+    const unsigned char* alive = data + n * sizeof(int);
+    const unsigned char* p = alive + n;
+    const unsigned char* end = data + bytes;
+    for (size_t i = 0; i < n; i++) {
+        const size_t c = first + i;
+        int organic;
+        std::memcpy(&organic, data + i * sizeof(int), sizeof(int));
+        delta.organic += (long long)organic - grid.organic[c];
+        grid.organic[c] = organic;
+        if (alive[i] > 1) return false;
+        delta.alive += (int)alive[i] - (int)grid.alive[c];
+        if (grid.alive[c]) released.push_back(grid.genome[c]);
+        grid.alive[c] = alive[i];
+        if (!alive[i]) {
+            grid.genome[c] = -1;
+            continue;
+        }
+        if ((size_t)(end - p) < botBytes) return false;
+        std::memcpy(&grid.energy[c], p, sizeof(int));
+        p += sizeof(int);
+        grid.ip[c] = p[0];
+        grid.dir[c] = p[1];
+        grid.color[c] = p[2];
+        p += 3;
+        std::memcpy(&grid.born[c], p, sizeof(unsigned));
+        p += sizeof(unsigned);
+        grid.genome[c] = slotOf(p);
+        p += genomeBytes;
+    }
+    return p == end;
+}
+
+// --- ГАЛО ---
+// В гало геном идёт отпечатком: соседние строки - почти всегда те же боты, что тиком раньше,
+// и их геномы уже есть в пуле получателя. Отпечатки, которых в пуле нет (или которые там
+// неоднозначны), получатель просит номерами ботов в блоке (промах), и отправитель досылает
+// байты этих геномов (заливка) - по номеру бота, поэтому отпечатку тут верить не приходится.
+// Слоты по отпечаткам обоих блоков тика; -1 - ждёт заливки
+typedef std::unordered_map<uint64_t, int> HaloSlots;
+
+// Номера ботов блока с неизвестным отпечатком - по одному на отпечаток
+static bool FindMisses(const std::vector<unsigned char>& block, int rows, HaloSlots& slots, std::vector<uint32_t>& misses) {
+    const size_t head = (size_t)rows * world.w * (sizeof(int) + 1), botBytes = BOT_STATE_BYTES + sizeof(uint64_t);
+    misses.clear();
+    if (block.size() < head || (block.size() - head) % botBytes != 0) return false;
+    const size_t bots = (block.size() - head) / botBytes;
+    for (size_t k = 0; k < bots; k++) {
+        uint64_t key;
+        std::memcpy(&key, &block[head + k * botBytes + BOT_STATE_BYTES], sizeof(key));
+        auto found = slots.emplace(key, -1);
+        if (!found.second) continue;
+        found.first->second = genomePool.Find(key);
+        if (found.first->second < 0) misses.push_back((uint32_t)k);
+    }
+    return true;
+}
+
+// Заливка на промахи соседа: геномы запрошенных ботов блока, упакованного в bots
+static bool PackFills(const std::vector<unsigned char>& request, const std::vector<int>& bots,
+                      std::vector<unsigned char>& out) {
+    if (request.size() % sizeof(uint32_t) != 0) return false;
+    for (size_t i = 0; i < request.size(); i += sizeof(uint32_t)) {
+        uint32_t k;
+        std::memcpy(&k, &request[i], sizeof(k));
+        if (k >= bots.size()) return false;
+        Put(out, genomePool.Get(worldGrid.genome[bots[k]]), genomeSize);
+    }
+    return true;
+}
+
+// Принятая заливка: геномы промахов блока по их отпечаткам
+static bool TakeFills(const std::vector<unsigned char>& block, int rows, const std::vector<uint32_t>& misses,
+                      const std::vector<unsigned char>& fill, std::unordered_map<uint64_t, const unsigned char*>& genomes) {
+    const size_t head = (size_t)rows * world.w * (sizeof(int) + 1), botBytes = BOT_STATE_BYTES + sizeof(uint64_t);
+    if (fill.size() != misses.size() * genomeSize) return false;
+    for (size_t j = 0; j < misses.size(); j++) {
+        uint64_t key;
+        std::memcpy(&key, &block[head + misses[j] * botBytes + BOT_STATE_BYTES], sizeof(key));
+        const unsigned char* genome = &fill[j * genomeSize];
+        if (GenomePool::Fingerprint(genome) != key) return false;
+        genomes[key] = genome;
+    }
+    return true;
+}
+
+#if !defined(_WIN32)
+
+// --- СЕТЬ ---
+// Сообщение - 4 байта длины и тело. Обмен гало идёт по обоим сокетам сразу (poll по
+// неблокирующим сокетам): соседи отправляют друг другу одновременно, и блокирующая запись
+// при заполненных буферах заперла бы обоих.
+const int DIST_CONNECT_TIMEOUT_MS = 60000; // Сколько ждать запуска соседей
+
+struct Channel {
+    int fd = -1;
+    std::vector<unsigned char> out; // С заголовком длины; пусто - нечего отправлять
+    std::vector<unsigned char>* in = nullptr; // nullptr - нечего принимать
+    size_t sent = 0, got = 0;
+    size_t need = 4; // Сколько байт (с заголовком) ждём в in
+};
+
+static void Frame(Channel& ch, const std::vector<unsigned char>& body) {
+    const uint32_t len = (uint32_t)body.size();
+    ch.out.resize(4);
+    std::memcpy(ch.out.data(), &len, 4);
+    ch.out.insert(ch.out.end(), body.begin(), body.end());
+    ch.sent = 0;
+}
+
+static bool Transfer(Channel* channels, int count, std::string* error) {
+    for (int i = 0; i < count; i++) {
+        if (channels[i].in) {
+            channels[i].in->resize(4);
+            channels[i].got = 0;
+            channels[i].need = 4;
+        }
+    }
+    for (;;) {
+        pollfd fds[2];
+        Channel* active[2];
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            Channel& ch = channels[i];
+            short events = 0;
+            if (ch.sent < ch.out.size()) events |= POLLOUT;
+            if (ch.in && ch.got < ch.need) events |= POLLIN;
+            if (!events) continue;
+            fds[n] = pollfd{ ch.fd, events, 0 };
+            active[n++] = &ch;
+        }
+        if (n == 0) return true;
+        int ready = poll(fds, n, DIST_CONNECT_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return Fail(error, "halo exchange timed out");
+        for (int k = 0; k < n; k++) {
+            Channel& ch = *active[k];
+            const short revents = fds[k].revents;
+            if (revents & (POLLERR | POLLNVAL)) return Fail(error, "connection error");
+            if ((revents & POLLOUT) && ch.sent < ch.out.size()) {
+                ssize_t w = send(ch.fd, ch.out.data() + ch.sent, ch.out.size() - ch.sent, MSG_NOSIGNAL);
+                if (w < 0 && errno != EAGAIN && errno != EINTR) return Fail(error, std::strerror(errno));
+                if (w > 0) ch.sent += (size_t)w;
+            }
+            if ((revents & (POLLIN | POLLHUP)) && ch.in && ch.got < ch.need) {
+                ssize_t r = recv(ch.fd, ch.in->data() + ch.got, ch.need - ch.got, 0);
+                if (r == 0) return Fail(error, "peer closed the connection");
+                if (r < 0 && errno != EAGAIN && errno != EINTR) return Fail(error, std::strerror(errno));
+                if (r > 0) ch.got += (size_t)r;
+                if (ch.got == 4 && ch.need == 4) {
+                    uint32_t len;
+                    std::memcpy(&len, ch.in->data(), 4);
+                    ch.need = 4 + (size_t)len;
+                    ch.in->resize(ch.need);
+                }
+            }
+        }
+    }
+}
+
+static bool SendMessage(int fd, const std::vector<unsigned char>& body, std::string* error) {
+    Channel ch;
+    ch.fd = fd;
+    Frame(ch, body);
+    return Transfer(&ch, 1, error);
+}
+
+// Тело сообщения - без заголовка длины
+static bool ReceiveMessage(int fd, std::vector<unsigned char>& body, std::string* error) {
+    Channel ch;
+    ch.fd = fd;
+    ch.in = &body;
+    if (!Transfer(&ch, 1, error)) return false;
+    body.erase(body.begin(), body.begin() + 4);
+    return true;
+}
+
+static bool SplitHost(const std::string& entry, std::string& host, std::string& port) {
+    size_t colon = entry.rfind(':');
+    if (colon == std::string::npos) return false;
+    host = entry.substr(0, colon);
+    port = entry.substr(colon + 1);
+    return !port.empty();
+}
+
+static void SetSocketOptions(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Гало - мелкие сообщения раз в тик
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static int Listen(const std::string& port, std::string* error) {
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(nullptr, port.c_str(), &hints, &res) != 0) {
+        Fail(error, "bad port " + port);
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* a = res; a && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, a->ai_addr, a->ai_addrlen) != 0 || listen(fd, 4) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0) Fail(error, "cannot listen on port " + port + ": " + std::strerror(errno));
+    return fd;
+}
+
+// Сосед может ещё не слушать: повторяем, пока не истечёт DIST_CONNECT_TIMEOUT_MS
+static int Connect(const std::string& host, const std::string& port, std::string* error) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DIST_CONNECT_TIMEOUT_MS);
+    for (;;) {
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) == 0) {
+            for (addrinfo* a = res; a; a = a->ai_next) {
+                int fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                if (fd < 0) continue;
+                if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) {
+                    freeaddrinfo(res);
+                    return fd;
+                }
+                close(fd);
+            }
+            freeaddrinfo(res);
+        }
+        if (std::chrono::steady_clock::now() > deadline) break;
+        usleep(100 * 1000);
+    }
+    Fail(error, "cannot connect to " + host + ":" + port);
+    return -1;
+}
+
+static int Accept(int listenFd, std::string* error) {
+    pollfd pfd{ listenFd, POLLIN, 0 };
+    if (poll(&pfd, 1, DIST_CONNECT_TIMEOUT_MS) <= 0) {
+        Fail(error, "no connection from the previous node");
+        return -1;
+    }
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) Fail(error, std::string("accept: ") + std::strerror(errno));
+    return fd;
+}
+
+static void CloseSocket(int& fd) {
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+#endif // !_WIN32
+
+// Параметры, которые у всех узлов кольца обязаны совпадать
+struct DistHello {
+    char magic[4];
+    int rank, nodes;
+    int w, h, genomeSize;
+    uint32_t seed;
+    SimRules rules;
+};
+
+DistNode::~DistNode() {
+#if !defined(_WIN32)
+    CloseSocket(prev_);
+    CloseSocket(next_);
+    CloseSocket(listen_);
+#endif
+}
+
+int DistNode::OwnedAlive() const {
+    int n = 0;
+    const size_t first = (size_t)DIST_HALO * world.w, end = first + (size_t)(rowEnd_ - rowBegin_) * world.w;
+    for (size_t i = first; i < end; i++) n += worldGrid.alive[i];
+    return n;
+}
+
+#if defined(_WIN32)
+
+bool DistNode::Start(int, const std::vector<std::string>&, std::string* error) {
+    return Fail(error, "distributed mode is not supported on Windows");
+}
+bool DistNode::Step(std::string* error) { return Fail(error, "distributed mode is not supported on Windows"); }
+bool DistNode::Gather(std::string* error) { return Fail(error, "distributed mode is not supported on Windows"); }
+
+#else
+
+bool DistNode::Start(int rank, const std::vector<std::string>& hosts, std::string* error) {
+    nodes_ = (int)hosts.size();
+    rank_ = rank;
+    if (rank_ < 0 || rank_ >= nodes_) return Fail(error, "node rank is out of range");
+    // Полоса - локальный тор с гало; края мира ей не передать
+    if (config.rules.bounded) return Fail(error, "a bounded world cannot be distributed");
+    globalW_ = config.worldW;
+    globalH_ = config.worldH;
+    rowBegin_ = (int)((long long)rank_ * globalH_ / nodes_);
+    rowEnd_ = (int)((long long)(rank_ + 1) * globalH_ / nodes_);
+    const int strip = rowEnd_ - rowBegin_;
+    if (strip < DIST_HALO) {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "strip of %d rows is thinner than the halo (%d): use fewer nodes", strip, DIST_HALO);
+        return Fail(error, buf);
+    }
+
+    std::string host, port, nextHost, nextPort;
+    if (!SplitHost(hosts[rank_], host, port) || !SplitHost(hosts[(rank_ + 1) % nodes_], nextHost, nextPort)) {
+        return Fail(error, "hosts must be host:port");
+    }
+    // Сначала все слушают, потом соединяются: connect проходит через очередь listen и без accept
+    listen_ = Listen(port, error);
+    if (listen_ < 0) return false;
+    next_ = Connect(nextHost, nextPort, error);
+    if (next_ < 0) return false;
+    prev_ = Accept(listen_, error);
+    if (prev_ < 0) return false;
+    SetSocketOptions(next_);
+    SetSocketOptions(prev_);
+
+    // Каждый узел представляется следующему и проверяет представление предыдущего
+    DistHello hello{ { 'A', 'L', 'D', 'N' }, rank_, nodes_, globalW_, globalH_, config.genomeSize, config.seed,
+                     config.rules };
+    std::vector<unsigned char> out((unsigned char*)&hello, (unsigned char*)&hello + sizeof(hello)), in;
+    if (!SendMessage(next_, out, error) || !ReceiveMessage(prev_, in, error)) return false;
+    DistHello peer;
+    if (in.size() != sizeof(peer)) return Fail(error, "bad handshake from the previous node");
+    std::memcpy(&peer, in.data(), sizeof(peer));
+    if (std::memcmp(peer.magic, hello.magic, 4) != 0 || peer.rank != (rank_ + nodes_ - 1) % nodes_ ||
+        peer.nodes != nodes_) {
+        return Fail(error, "previous node is not part of this ring (check --dist-hosts and --dist-rank)");
+    }
+    if (peer.w != hello.w || peer.h != hello.h || peer.genomeSize != hello.genomeSize || peer.seed != hello.seed ||
+        !peer.rules.SameNumbers(hello.rules)) {
+        return Fail(error, "previous node runs a different world (size, genome, seed or rules)");
+    }
+
+    // Локальный тор: DIST_HALO строк сверху, своя полоса, DIST_HALO строк снизу
+    config.worldH = strip + 2 * DIST_HALO;
+    worldPartition.base = (long long)((rowBegin_ - DIST_HALO + globalH_) % globalH_) * globalW_;
+    worldPartition.cells = (long long)globalW_ * globalH_;
+    InitWorld();
+    config.worldH = globalH_;
+    worldPartition = WorldPartition();
+    return true;
+}
+
+bool DistNode::Step(std::string* error) {
+    UpdateWorld();
+
+    auto start = std::chrono::steady_clock::now();
+    ProfScope scope(PROF_HALO);
+    const int strip = rowEnd_ - rowBegin_;
+    // Канал 0 - предыдущий узел: ему наши первые строки (у него это нижнее гало), от него - верхнее гало.
+    // Канал 1 - следующий: ему последние строки, от него - нижнее гало
+    const int sendRow[2] = { DIST_HALO, strip }, haloRow[2] = { 0, DIST_HALO + strip };
+    std::vector<unsigned char> out[2], in[2];
+    auto exchange = [&](const bool send[2], const bool receive[2]) {
+        Channel channels[2];
+        for (int k = 0; k < 2; k++) {
+            channels[k].fd = k == 0 ? prev_ : next_;
+            if (send[k]) Frame(channels[k], out[k]);
+            channels[k].in = receive[k] ? &in[k] : nullptr;
+        }
+        if (!Transfer(channels, 2, error)) return false;
+        for (int k = 0; k < 2; k++) {
+            if (receive[k]) in[k].erase(in[k].begin(), in[k].begin() + 4);
+        }
+        return true;
+    };
+    const bool both[2] = { true, true };
+
+    // 1. Строки с отпечатками геномов
+    std::vector<unsigned char> blocks[2];
+    std::vector<int> sent[2];
+    for (int k = 0; k < 2; k++) PackRows(sendRow[k], DIST_HALO, true, out[k], &sent[k]);
+    if (!exchange(both, both)) return false;
+    blocks[0].swap(in[0]);
+    blocks[1].swap(in[1]);
+
+    // 2. Промахи - номера ботов, чьих геномов у нас нет, - обратно отправителю
+    HaloSlots slots;
+    std::vector<uint32_t> misses[2];
+    for (int k = 0; k < 2; k++) {
+        if (!FindMisses(blocks[k], DIST_HALO, slots, misses[k])) return Fail(error, "malformed halo rows");
+        const unsigned char* list = (const unsigned char*)misses[k].data();
+        out[k].assign(list, list + misses[k].size() * sizeof(uint32_t));
+    }
+    if (!exchange(both, both)) return false;
+
+    // 3. Заливка - только по каналам с промахами; кто с какой стороны был, знают оба
+    bool fillOut[2], fillIn[2];
+    for (int k = 0; k < 2; k++) {
+        fillOut[k] = !in[k].empty();
+        fillIn[k] = !misses[k].empty();
+        out[k].clear();
+        if (!PackFills(in[k], sent[k], out[k])) return Fail(error, "malformed genome request");
+    }
+    if ((fillOut[0] || fillOut[1] || fillIn[0] || fillIn[1]) && !exchange(fillOut, fillIn)) return false;
+    std::unordered_map<uint64_t, const unsigned char*> genomes;
+    for (int k = 0; k < 2; k++) {
+        if (fillIn[k] && !TakeFills(blocks[k], DIST_HALO, misses[k], in[k], genomes)) {
+            return Fail(error, "malformed genome fill");
+        }
+    }
+
+    // 4. Запись гало: отпечаток -> слот (+1 ссылка); залитый геном интернирует первый его бот
+    auto slotOf = [&](const unsigned char* field) {
+        uint64_t key;
+        std::memcpy(&key, field, sizeof(key));
+        int& slot = slots[key];
+        if (slot >= 0) genomePool.Retain(slot);
+        else slot = genomePool.Intern(genomes[key]);
+        return slot;
+    };
+    RowsDelta delta[2];
+    std::vector<int> released;
+    for (int k = 0; k < 2; k++) {
+        if (!UnpackRows(blocks[k].data(), blocks[k].size(), haloRow[k], DIST_HALO, sizeof(uint64_t), slotOf, delta[k],
+                        released)) {
+            return Fail(error, "malformed halo rows");
+        }
+    }
+    for (int slot : released) genomePool.Release(slot);
+    for (int k = 0; k < 2; k++) RefreshRows(haloRow[k], DIST_HALO, delta[k].alive, delta[k].organic);
+    exchangeMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+// Полосы идут по кольцу назад: узел k получает от k + 1 полосы k + 1..N - 1, дописывает свою
+// и отдаёт узлу k - 1. Запись полосы: первая глобальная строка, число строк, длина блока, блок.
+bool DistNode::Gather(std::string* error) {
+    std::vector<unsigned char> bundle;
+    if (rank_ + 1 < nodes_ && !ReceiveMessage(next_, bundle, error)) return false;
+
+    std::vector<unsigned char> own;
+    PackRows(DIST_HALO, rowEnd_ - rowBegin_, false, own);
+    const uint32_t head[3] = { (uint32_t)rowBegin_, (uint32_t)(rowEnd_ - rowBegin_), (uint32_t)own.size() };
+    std::vector<unsigned char> strips((const unsigned char*)head, (const unsigned char*)head + sizeof(head));
+    strips.insert(strips.end(), own.begin(), own.end());
+    strips.insert(strips.end(), bundle.begin(), bundle.end());
+    if (rank_ > 0) return SendMessage(prev_, strips, error);
+
+    const unsigned tick = worldTick;
+    AllocateWorld();
+    worldTick = tick;
+    size_t pos = 0;
+    int rows = 0;
+    RowsDelta delta;
+    std::vector<int> released; // Мир только что пуст - прежних ботов нет
+    auto intern = [](const unsigned char* genome) { return genomePool.Intern(genome); };
+    while (pos + sizeof(head) <= strips.size()) {
+        uint32_t h[3];
+        std::memcpy(h, &strips[pos], sizeof(h));
+        pos += sizeof(h);
+        if (h[0] + h[1] > (uint32_t)globalH_ || pos + h[2] > strips.size() ||
+            !UnpackRows(&strips[pos], h[2], (int)h[0], (int)h[1], genomeSize, intern, delta, released)) {
+            return Fail(error, "malformed strip");
+        }
+        pos += h[2];
+        rows += (int)h[1];
+    }
+    if (rows != globalH_) return Fail(error, "strips do not cover the world");
+    RebuildBotLists();
+    return true;
+}
+
+#endif // _WIN32
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "vm.h"
+
+// --- РАСПРЕДЕЛЁННЫЙ МИР ---
+// Мир делится на N горизонтальных полос целых строк, по полосе на процесс (узел); узлы
+// соединены в кольцо по TCP: каждый держит связь с соседом сверху (prev) и снизу (next).
+// Узел считает свою полосу обычным UpdateWorld как отдельный тор высотой strip + 2 * DIST_HALO:
+// сверху и снизу - копии чужих строк (гало). После тика узел отсылает соседям свои крайние
+// DIST_HALO строк и принимает их строки в гало. Порча от локального "шва" тора за тик уходит
+// вглубь не дальше DIST_HALO строк и не доходит до своих строк; гало каждый тик перезаписывается.
+// Геномы в гало идут отпечатками, байты - только тех, которых у получателя нет (distributed.cpp);
+// после записи гало списки тайлов и индекс догоняют только его строки (RefreshRows).
+// Случайные числа и споры заявок идут по глобальному номеру клетки (WorldGeometry::GlobalCell),
+// поэтому полосы вместе дают ровно тот же мир, что и одиночный прогон с тем же seed.
+// В конце узлы пересылают полосы по кольцу узлу 0, и он собирает весь мир (сумма, сохранение).
+
+// Дальше всего бот читает при ходе: клетка перед собой (1), толпа в SENSE_RADIUS,
+// органика в квадрате радиуса 1 за SENSE_ORGANIC_REACH клеток
+const int VM_READ_REACH = std::max(1, std::max(SENSE_RADIUS, SENSE_ORGANIC_REACH + 1));
+// Клетка своих строк после тика зависит от клеток на расстоянии: цель бота-соседа (1) ->
+// соперник за неё (1) -> его собственная цель (1) -> всё, что он прочёл (VM_READ_REACH),
+// и ещё 1 на диффузию органики
+const int DIST_HALO = 3 + VM_READ_REACH + 1;
+
+// Узлы - "host:port" через запятую, по одному на полосу, в порядке полос
+bool ParseDistHosts(const char* list, std::vector<std::string>& hosts);
+
+class DistNode {
+public:
+    ~DistNode();
+
+    // Разбить мир config на полосы, поднять свою полосу (InitWorld) и соединиться с соседями.
+    // Все узлы должны быть запущены с одинаковым config (размеры, seed, геном) - это сверяется
+    bool Start(int rank, const std::vector<std::string>& hosts, std::string* error);
+    // Тик полосы + обмен гало
+    bool Step(std::string* error);
+    // Собрать полосы на узле 0: после возврата там в worldGrid весь мир. На остальных узлах мир не меняется
+    bool Gather(std::string* error);
+
+    int Rank() const { return rank_; }
+    int Nodes() const { return nodes_; }
+    int RowBegin() const { return rowBegin_; } // Свои строки глобального мира [RowBegin, RowEnd)
+    int RowEnd() const { return rowEnd_; }
+    int OwnedAlive() const;                    // Живых в своих строках (aliveCount включает гало)
+    double ExchangeMs() const { return exchangeMs_; } // Обмен гало за всё время
+
+private:
+    int rank_ = 0, nodes_ = 1;
+    int rowBegin_ = 0, rowEnd_ = 0;
+    int globalW_ = 0, globalH_ = 0;
+    int prev_ = -1, next_ = -1, listen_ = -1; // Сокеты
+    double exchangeMs_ = 0;
+};
@@ -0,0 +1,370 @@
+#include "gpu_sim.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "rlgl.h"
+#include "sim.h"
+
+// rlgl не даёт glMemoryBarrier, а без него следующий dispatch может не увидеть записи предыдущего.
+// Указатель берём у GLFW, который raylib уже слинковал на ПК.
+typedef void (*GlProc)(void);
+extern "C" GlProc glfwGetProcAddress(const char* name);
+typedef void (*MemoryBarrierFn)(unsigned int barriers);
+
+static const unsigned GL_SHADER_STORAGE_BARRIER = 0x00002000;
+static const unsigned GL_SHADER_IMAGE_ACCESS_BARRIER = 0x00000020;
+static const unsigned GL_TEXTURE_FETCH_BARRIER = 0x00000008;
+static const unsigned GL_BUFFER_UPDATE_BARRIER = 0x00000200;
+
+static void GlMemoryBarrier(unsigned barriers) {
+    static MemoryBarrierFn fn = (MemoryBarrierFn)glfwGetProcAddress("glMemoryBarrier");
+    if (fn) fn(barriers);
+}
+
+// Раскладка std430: только 4-байтовые скаляры, порядок как в блоке Params шейдера
+struct GpuParams {
+    int w, h, genomeSize, cells;
+    unsigned organicKey, growThreshold, rowStride, tick;
+    int alive;
+    int pad[3];
+};
+
+const int GPU_GROUP_SIZE = 256;
+const int GPU_MAX_GROUPS = 65535; // Минимальный гарантированный лимит по одной оси
+
+// --- ШЕЙДЕРЫ ---
+// Константы правил и раскладки подставляются из C++, чтобы CPU и GPU не разошлись.
+static std::string ShaderPrelude() {
+    std::string s = "#version 430\n";
+    auto define = [&](const char* name, long long value) {
+        s += "#define " + std::string(name) + " " + std::to_string(value) + "\n";
+    };
+    define("GROUP_SIZE", GPU_GROUP_SIZE);
+    define("OP_PHOTOSYNTHESIS", VM_OP_PHOTOSYNTHESIS);
+    define("OP_EAT", VM_OP_EAT);
+    define("OP_MOVE", VM_OP_MOVE);
+    define("ACTION_STAY", ACTION_STAY);
+    define("ACTION_MOVE", ACTION_MOVE);
+    define("ACTION_ATTACK", ACTION_ATTACK);
+    define("ACTION_DIE", ACTION_DIE);
+    define("ACTION_NONE", 15); // Пустая клетка: намерения нет
+    define("COLOR_GREEN", BOT_COLOR_GREEN);
+    define("COLOR_RED", BOT_COLOR_RED);
+    define("ORGANIC_GROWTH", ORGANIC_GROWTH);
+    s += R"(
+layout(local_size_x = GROUP_SIZE) in;
+
+layout(std430, binding = 0) buffer Params {
+    int w, h, genomeSize, cells;
+    uint organicKey, growThreshold, rowStride, tick;
+    int alive;
+};
+// alive | ip << 8 | dir << 16 | color << 24
+layout(std430, binding = 1) buffer State { uint state[]; };
+layout(std430, binding = 2) buffer Energy { int energy[]; };
+layout(std430, binding = 3) buffer Organic { int organic[]; };
+layout(std430, binding = 4) buffer Genome { int genome[]; };
+// VmStep: op | turn << 8 | next << 16 (тот же байтовый формат, что в GenomePool::code)
+layout(std430, binding = 5) buffer Code { uint code[]; };
+// packed: ip | dir << 8 | color << 16 | action << 20 | eaten << 24
+struct Intent { int target; int energy; uint packed; int unused; };
+layout(std430, binding = 6) buffer Intents { Intent intents[]; };
+layout(std430, binding = 7) buffer Claims { int claims[]; };
+layout(std430, binding = 8) buffer Born { uint born[]; };
+
+const int NO_CLAIM = 0x7FFFFFFF;
+const int DIR_X[8] = int[8](0, 1, 1, 1, 0, -1, -1, -1);
+const int DIR_Y[8] = int[8](-1, -1, 0, 1, 1, 1, 0, -1);
+
+int CellIndex() {
+    uint i = gl_GlobalInvocationID.y * rowStride + gl_GlobalInvocationID.x;
+    return i < uint(cells) ? int(i) : -1;
+}
+
+uint Hash32(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Деление с отбрасыванием к нулю, как в C++ (для отрицательных в GLSL не определено)
+int Half(int v) { return v >= 0 ? v / 2 : -((-v) / 2); }
+)";
+    return s;
+}
+
+static const char* THINK_SHADER = R"(
+void main() {
+    int i = CellIndex();
+    if (i < 0) return;
+    claims[i] = NO_CLAIM;
+
+    uint s = state[i];
+    if ((s & 1u) == 0u) {
+        intents[i].target = -1;
+        intents[i].packed = uint(ACTION_NONE) << 20;
+        if (Hash32(organicKey ^ uint(i)) < growThreshold) organic[i] += ORGANIC_GROWTH;
+        return;
+    }
+
+    int e = energy[i];
+    int target = -1;
+    uint eaten = 0u;
+    uint ip = 0u, dir = 0u, color = 0u;
+    uint action = uint(ACTION_DIE);
+    if (e > 0) {
+        uint step = code[uint(genome[i]) * uint(genomeSize) + ((s >> 8) & 255u)];
+        uint op = step & 255u;
+        ip = (step >> 16) & 255u;
+        dir = (((s >> 16) & 255u) + ((step >> 8) & 255u)) & 7u;
+        color = (s >> 24) & 255u;
+        action = uint(ACTION_STAY);
+        if (op == uint(OP_PHOTOSYNTHESIS)) {
+            e += 5;
+            color = uint(COLOR_GREEN);
+        } else if (op == uint(OP_EAT)) {
+            int org = organic[i];
+            if (org > 0) {
+                eaten = uint(min(org, 20));
+                e += int(eaten);
+                color = uint(COLOR_RED);
+            }
+        } else if (op == uint(OP_MOVE)) {
+            int nx = (i % w + DIR_X[dir] + w) % w;
+            int ny = (i / w + DIR_Y[dir] + h) % h;
+            target = ny * w + nx;
+            action = (state[target] & 1u) != 0u ? uint(ACTION_ATTACK) : uint(ACTION_MOVE);
+        }
+        e -= 1;
+    }
+    intents[i].target = target;
+    intents[i].energy = e;
+    intents[i].packed = ip | (dir << 8) | (color << 16) | (action << 20) | (eaten << 24);
+}
+)";
+
+static const char* CLAIM_SHADER = R"(
+void main() {
+    int i = CellIndex();
+    if (i < 0) return;
+    int target = intents[i].target;
+    if (target >= 0) atomicMin(claims[target], i);
+}
+)";
+
+static const char* COMMIT_SHADER = R"(
+void main() {
+    int i = CellIndex();
+    if (i < 0) return;
+    uint packed = intents[i].packed;
+    uint action = (packed >> 20) & 15u;
+    if (action == uint(ACTION_NONE)) return;
+
+    if (action == uint(ACTION_DIE)) {
+        state[i] = 0u;
+        organic[i] += 50; // Труп разлагается
+        return;
+    }
+    // Бота съел сосед
+    if (claims[i] != NO_CLAIM) {
+        state[i] = 0u;
+        return;
+    }
+
+    int target = intents[i].target;
+    int e = intents[i].energy;
+    bool won = target >= 0 && claims[target] == i;
+    int pos = i;
+    if (action == uint(ACTION_MOVE) && won) {
+        pos = target;
+        e -= 2;
+        state[i] = 0u;
+    } else if (action == uint(ACTION_ATTACK) && won) {
+        e += Half(energy[target]);
+    }
+
+    organic[i] -= int(packed >> 24);
+    int slot = genome[i];
+    state[pos] = 1u | ((packed & 255u) << 8) | (((packed >> 8) & 255u) << 16) | (((packed >> 16) & 15u) << 24);
+    energy[pos] = e;
+    genome[pos] = slot;
+    if (pos != i) born[pos] = born[i];
+    atomicAdd(alive, 1);
+}
+)";
+
+// Цвета как в DrawWorld (main.cpp)
+static const char* COLOR_SHADER = R"(
+layout(rgba8, binding = 0) uniform writeonly image2D screen;
+
+void main() {
+    int i = CellIndex();
+    if (i < 0) return;
+    uint s = state[i];
+    vec4 c;
+    if ((s & 1u) != 0u) {
+        c = ((s >> 24) & 255u) == uint(COLOR_GREEN) ? vec4(0.0, 1.0, 0.0, 1.0) : vec4(150.0 / 255.0, 0.0, 0.0, 1.0);
+    } else {
+        int org = min(clamp(organic[i], 0, 255) * 2, 255);
+        c = vec4(float(org) / 255.0, float(org / 2) / 255.0, 0.0, 1.0);
+    }
+    imageStore(screen, ivec2(i % w, i / w), c);
+}
+)";
+
+static unsigned LoadProgram(const char* body) {
+    std::string code = ShaderPrelude() + body;
+    unsigned shader = rlCompileShader(code.c_str(), RL_COMPUTE_SHADER);
+    if (shader == 0) return 0;
+    return rlLoadComputeShaderProgram(shader);
+}
+
+bool GpuSim::Available() { return rlGetVersion() == RL_OPENGL_43; }
+
+bool GpuSim::Start() {
+    if (active_ || !Available()) return active_;
+    // Числа экономики вшиты в шейдеры, мир - тор
+    if (simRules.bounded || !simRules.SameNumbers(ClassicRules<false>::Value())) {
+        std::fprintf(stderr, "gpu: the GPU backend runs only the classic rules on a torus\n");
+        return false;
+    }
+    // rlLoadShaderBuffer принимает размер в unsigned int
+    if ((long long)world.cells * (long long)sizeof(int) * 4 > 0x7FFFFFFFLL) {
+        std::fprintf(stderr, "gpu: world %dx%d is too large for the GPU backend\n", world.w, world.h);
+        return false;
+    }
+
+    thinkProgram_ = LoadProgram(THINK_SHADER);
+    claimProgram_ = LoadProgram(CLAIM_SHADER);
+    commitProgram_ = LoadProgram(COMMIT_SHADER);
+    colorProgram_ = LoadProgram(COLOR_SHADER);
+    if (!thinkProgram_ || !claimProgram_ || !commitProgram_ || !colorProgram_) {
+        std::fprintf(stderr, "gpu: compute shaders failed to build\n");
+        Release();
+        return false;
+    }
+
+    const int cells = world.cells;
+    const WorldBuffer& grid = worldGrid;
+    std::vector<unsigned> packed(cells);
+    for (int i = 0; i < cells; i++) {
+        packed[i] = grid.alive[i] ? (1u | grid.ip[i] << 8 | grid.dir[i] << 16 | (unsigned)grid.color[i] << 24) : 0u;
+    }
+    const unsigned cellBytes = (unsigned)(cells * sizeof(int));
+    state_ = rlLoadShaderBuffer(cellBytes, packed.data(), RL_DYNAMIC_COPY);
+    energy_ = rlLoadShaderBuffer(cellBytes, grid.energy.data(), RL_DYNAMIC_COPY);
+    organic_ = rlLoadShaderBuffer(cellBytes, grid.organic.data(), RL_DYNAMIC_COPY);
+    genome_ = rlLoadShaderBuffer(cellBytes, grid.genome.data(), RL_DYNAMIC_COPY);
+    born_ = rlLoadShaderBuffer(cellBytes, grid.born.data(), RL_DYNAMIC_COPY);
+    claims_ = rlLoadShaderBuffer(cellBytes, nullptr, RL_DYNAMIC_COPY);
+    intents_ = rlLoadShaderBuffer(cellBytes * 4, nullptr, RL_DYNAMIC_COPY);
+    // Пустой пул геномов - всё равно нужен непустой буфер
+    unsigned codeBytes = (unsigned)std::max<size_t>(genomePool.code.size() * sizeof(VmStep), sizeof(VmStep));
+    code_ = rlLoadShaderBuffer(codeBytes, genomePool.code.empty() ? nullptr : genomePool.code.data(), RL_STATIC_DRAW);
+    params_ = rlLoadShaderBuffer(sizeof(GpuParams), nullptr, RL_DYNAMIC_COPY);
+
+    int groups = (cells + GPU_GROUP_SIZE - 1) / GPU_GROUP_SIZE;
+    groupsX_ = (unsigned)std::min(groups, GPU_MAX_GROUPS);
+    groupsY_ = (unsigned)((groups + groupsX_ - 1) / groupsX_);
+
+    active_ = true;
+    UploadParams();
+    return true;
+}
+
+void GpuSim::UploadParams() {
+    GpuParams p = {};
+    p.w = world.w;
+    p.h = world.h;
+    p.genomeSize = genomeSize;
+    p.cells = world.cells;
+    p.organicKey = OrganicKey(worldTick);
+    p.growThreshold = ORGANIC_GROWTH_THRESHOLD;
+    p.rowStride = groupsX_ * GPU_GROUP_SIZE;
+    p.tick = worldTick;
+    p.alive = 0;
+    rlUpdateShaderBuffer(params_, &p, sizeof(p), 0);
+}
+
+void GpuSim::Dispatch(unsigned program) {
+    rlEnableShader(program);
+    rlBindShaderBuffer(params_, 0);
+    rlBindShaderBuffer(state_, 1);
+    rlBindShaderBuffer(energy_, 2);
+    rlBindShaderBuffer(organic_, 3);
+    rlBindShaderBuffer(genome_, 4);
+    rlBindShaderBuffer(code_, 5);
+    rlBindShaderBuffer(intents_, 6);
+    rlBindShaderBuffer(claims_, 7);
+    rlBindShaderBuffer(born_, 8);
+    rlComputeShaderDispatch(groupsX_, groupsY_, 1);
+    rlDisableShader();
+    GlMemoryBarrier(GL_SHADER_STORAGE_BARRIER);
+}
+
+// worldTick идёт вместе с GPU: ключ роста органики и сравнение с CPU привязаны к номеру тика
+void GpuSim::Tick(int ticks) {
+    if (!active_) return;
+    for (int t = 0; t < ticks; t++) {
+        UploadParams();
+        Dispatch(thinkProgram_);
+        Dispatch(claimProgram_);
+        Dispatch(commitProgram_);
+        worldTick++;
+    }
+}
+
+void GpuSim::Render(Texture2D target) {
+    if (!active_) return;
+    rlBindImageTexture(target.id, 0, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, false);
+    Dispatch(colorProgram_);
+    GlMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER | GL_TEXTURE_FETCH_BARRIER);
+}
+
+int GpuSim::Alive() {
+    if (!active_) return aliveCount;
+    GlMemoryBarrier(GL_BUFFER_UPDATE_BARRIER);
+    GpuParams p;
+    rlReadShaderBuffer(params_, &p, sizeof(p), 0);
+    return p.alive;
+}
+
+void GpuSim::Finish() {
+    if (!active_) return;
+    GlMemoryBarrier(GL_BUFFER_UPDATE_BARRIER);
+    const int cells = world.cells;
+    const unsigned cellBytes = (unsigned)(cells * sizeof(int));
+    WorldBuffer& grid = worldGrid;
+    std::vector<unsigned> packed(cells);
+    rlReadShaderBuffer(state_, packed.data(), cellBytes, 0);
+    rlReadShaderBuffer(energy_, grid.energy.data(), cellBytes, 0);
+    rlReadShaderBuffer(organic_, grid.organic.data(), cellBytes, 0);
+    rlReadShaderBuffer(genome_, grid.genome.data(), cellBytes, 0);
+    rlReadShaderBuffer(born_, grid.born.data(), cellBytes, 0);
+    for (int i = 0; i < cells; i++) {
+        unsigned s = packed[i];
+        grid.alive[i] = (unsigned char)(s & 1u);
+        grid.ip[i] = (unsigned char)(s >> 8);
+        grid.dir[i] = (unsigned char)(s >> 16);
+        grid.color[i] = (unsigned char)(s >> 24);
+    }
+    RebuildBotLists();
+    Release();
+}
+
+void GpuSim::Release() {
+    for (unsigned* program : { &thinkProgram_, &claimProgram_, &commitProgram_, &colorProgram_ }) {
+        if (*program) rlUnloadShaderProgram(*program);
+        *program = 0;
+    }
+    for (unsigned* buffer : { &params_, &state_, &energy_, &organic_, &genome_, &code_, &intents_, &claims_, &born_ }) {
+        if (*buffer) rlUnloadShaderBuffer(*buffer);
+        *buffer = 0;
+    }
+    active_ = false;
+}
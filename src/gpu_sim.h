@@ -0,0 +1,44 @@
+#pragma once
+
+#include "raylib.h"
+
+// --- GPU-БЭКЕНД ТИКА (OpenGL 4.3 compute) ---
+// Тот же двухфазный тик, что и в sim.cpp, но по потоку на клетку:
+//   think  - рост органики в пустых клетках + ход VM (по скомпилированному коду генома),
+//   claim  - atomicMin заявок: побеждает наименьшая клетка-источник, как на CPU,
+//   commit - применение намерений (каждую клетку пишет ровно один поток).
+// Сетка живёт в SSBO всё время работы бэкенда; кадр раскрашивается compute-шейдером
+// прямо в текстуру экрана - копирования пикселей с CPU нет.
+// Состояние возвращается в worldGrid только при выключении (Finish), поэтому результат
+// можно сравнить с CPU по WorldChecksum().
+// Геномы на GPU только читаются: новых слотов не бывает, поэтому деления (VM_OP_DIVIDE) нет -
+// команда там пустая, и мир с делящимися ботами расходится с CPU. Диффузии органики и команд-запросов
+// к окрестности (VM_OP_SENSE_*, нужен SpatialIndex) там тоже нет - они пустые.
+// Поток симуляции на время работы бэкенда должен быть остановлен.
+class GpuSim {
+public:
+    ~GpuSim() { Release(); }
+
+    // Контекст raylib собран с OpenGL 4.3 (compute-шейдеры и SSBO)
+    static bool Available();
+
+    // Загрузить текущее состояние мира в видеопамять. false - не собрались шейдеры или мир слишком велик
+    bool Start();
+    // Прочитать состояние обратно в worldGrid (+ RebuildBotLists) и освободить ресурсы
+    void Finish();
+    bool Active() const { return active_; }
+
+    void Tick(int ticks);
+    void Render(Texture2D target); // RGBA8 размером с мир
+    int Alive();                   // Боты после последнего тика (маленький readback)
+
+private:
+    void Release();
+    void Dispatch(unsigned program);
+    void UploadParams();
+
+    bool active_ = false;
+    unsigned thinkProgram_ = 0, claimProgram_ = 0, commitProgram_ = 0, colorProgram_ = 0;
+    unsigned params_ = 0, state_ = 0, energy_ = 0, organic_ = 0, genome_ = 0, code_ = 0, intents_ = 0, claims_ = 0, born_ = 0;
+    unsigned groupsX_ = 1, groupsY_ = 1;
+};
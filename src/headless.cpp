@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "distributed.h"
+#include "profiler.h"
+#include "replay.h"
+#include "save.h"
+#include "sim.h"
+#include "stats.h"
+
+// --- HEADLESS-РЕЖИМ ---
+// Прогон симуляции без окна и без raylib: N тиков так быстро, как позволяет железо.
+// Для ночных прогонов эволюции и отслеживания производительности в CI.
+//   ALifeSimHeadless --ticks 10000 --width 4096 --height 4096 --threads 32 --report 1000
+// В конце печатается разбивка тика по фазам; --profile out.json|out.csv сохраняет её в файл.
+// --load world.sav продолжает сохранённый мир вместо нового, --save world.sav пишет мир после
+// прогона (--compress - секции в zstd, если собрано с ним). --stats pop.csv пишет ряд статистики по тикам.
+// Распределённый прогон (distributed.h): процесс на полосу мира, одинаковые параметры у всех,
+//   ALifeSimHeadless --seed 7 --ticks 1000 --dist-hosts a:7000,b:7000,c:7000 --dist-rank 1
+// Узел 0 в конце собирает весь мир: печатает его сумму (ту же, что у одиночного прогона) и пишет --save.
+// --replay dir пишет журнал прогона (replay.h); --seek T после прогона переходит по нему к тику T
+// (сумма в конце - уже мира на тике T).
+
+struct HeadlessOptions {
+    long long ticks = 1000;
+    long long report = 100; // Печатать строку прогресса каждые N тиков (0 = только итог)
+    const char* profile = nullptr; // Файл экспорта профайлера
+    const char* load = nullptr;    // Сохранение, с которого начать
+    const char* save = nullptr;    // Куда сохранить мир в конце
+    bool compress = false;
+    std::vector<std::string> distHosts; // Узлы распределённого прогона; пусто - обычный прогон
+    int distRank = 0;
+    long long seek = -1; // Тик, к которому перейти по журналу после прогона
+};
+
+static void ParseHeadlessArgs(HeadlessOptions& opts, int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--compress") == 0) opts.compress = true;
+        if (i + 1 >= argc) break;
+        if (std::strcmp(argv[i], "--ticks") == 0) opts.ticks = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--report") == 0) opts.report = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--profile") == 0) opts.profile = argv[++i];
+        else if (std::strcmp(argv[i], "--load") == 0) opts.load = argv[++i];
+        else if (std::strcmp(argv[i], "--save") == 0) opts.save = argv[++i];
+        else if (std::strcmp(argv[i], "--seek") == 0) opts.seek = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--dist-rank") == 0) opts.distRank = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--dist-hosts") == 0 && !ParseDistHosts(argv[++i], opts.distHosts)) {
+            std::fprintf(stderr, "--dist-hosts: expected host:port[,host:port...]\n");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    HeadlessOptions opts;
+    ParseArgs(config, argc, argv);
+    ParseHeadlessArgs(opts, argc, argv);
+    ClampConfig(config);
+
+    typedef std::chrono::steady_clock Clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    workerPool.SetPinBigCores(config.pinBigCores);
+    workerPool.Resize(config.threads);
+
+    DistNode dist;
+    const bool distributed = !opts.distHosts.empty();
+    auto initStart = Clock::now();
+    if (distributed) {
+        // Продолжение сохранения пришлось бы сначала разрезать на полосы - пока не поддержано
+        if (opts.load) {
+            std::fprintf(stderr, "--load is not supported in a distributed run\n");
+            return 1;
+        }
+        std::string error;
+        if (!dist.Start(opts.distRank, opts.distHosts, &error)) {
+            std::fprintf(stderr, "node %d: %s\n", opts.distRank, error.c_str());
+            return 1;
+        }
+    } else if (opts.load) {
+        std::string error;
+        if (!LoadWorld(opts.load, &error)) {
+            std::fprintf(stderr, "cannot load %s: %s\n", opts.load, error.c_str());
+            return 1;
+        }
+    } else {
+        InitWorld();
+    }
+    double initMs = ms(Clock::now() - initStart);
+
+    std::printf("world %dx%d, genome %d, threads %d, seed %u, vm %s (%s), rules %s\n",
+                world.w, world.h, genomeSize, workerPool.Size(), config.seed,
+                VmModeName(vmMode), vmMode == VM_MODE_SCALAR ? "reference" : VmSimdKernel(), VmRulesKernel());
+    if (distributed) {
+        std::printf("node %d of %d: rows [%d, %d) of %d, halo %d rows\n", dist.Rank(), dist.Nodes(),
+                    dist.RowBegin(), dist.RowEnd(), config.worldH, DIST_HALO);
+    }
+    std::printf("%s %.1f ms, alive %d, tick %u\n", opts.load ? "load" : "init", initMs,
+                distributed ? dist.OwnedAlive() : (int)aliveCount, worldTick);
+
+    StatsRecorder recorder;
+    if (!config.stats.empty() && distributed) {
+        std::fprintf(stderr, "--stats is ignored in a distributed run\n");
+    } else if (!config.stats.empty()) {
+        if (recorder.Open(config.stats.c_str())) statsRecorder = &recorder;
+        else std::fprintf(stderr, "cannot write stats %s\n", config.stats.c_str());
+    }
+
+    ReplayRecorder replay;
+    if (!config.replay.empty() && distributed) {
+        std::fprintf(stderr, "--replay is ignored in a distributed run\n");
+    } else if (!config.replay.empty()) {
+        std::string error;
+        if (replay.Open(config.replay, config.replayInterval, config.replayKeyframes, &error)) replayRecorder = &replay;
+        else std::fprintf(stderr, "cannot start replay: %s\n", error.c_str());
+    }
+
+    double minTick = 1e30, maxTick = 0, totalTick = 0;
+    double windowTick = 0;
+    long long windowTicks = 0;
+
+    for (long long t = 1; t <= opts.ticks; t++) {
+        auto tickStart = Clock::now();
+        if (!distributed) {
+            UpdateWorld();
+        } else {
+            std::string error;
+            if (!dist.Step(&error)) {
+                std::fprintf(stderr, "node %d, tick %lld: %s\n", dist.Rank(), t, error.c_str());
+                return 1;
+            }
+        }
+        double tickMs = ms(Clock::now() - tickStart);
+
+        minTick = std::min(minTick, tickMs);
+        maxTick = std::max(maxTick, tickMs);
+        totalTick += tickMs;
+        windowTick += tickMs;
+        windowTicks++;
+
+        if (opts.report > 0 && (t % opts.report == 0 || t == opts.ticks)) {
+            std::printf("tick %lld  alive %d  %.0f ticks/s  %.3f ms/tick\n",
+                        t, distributed ? dist.OwnedAlive() : (int)aliveCount, windowTicks * 1000.0 / windowTick, windowTick / windowTicks);
+            std::fflush(stdout);
+            windowTick = 0;
+            windowTicks = 0;
+        }
+    }
+
+    if (opts.ticks > 0) {
+        std::printf("done: %lld ticks in %.1f ms, %.0f ticks/s, tick min/avg/max %.3f/%.3f/%.3f ms, alive %d\n",
+                    opts.ticks, totalTick, opts.ticks * 1000.0 / totalTick,
+                    minTick, totalTick / opts.ticks, maxTick, distributed ? dist.OwnedAlive() : (int)aliveCount);
+    }
+    if (distributed) {
+        std::printf("halo exchange %.1f ms\n", dist.ExchangeMs());
+        std::string error;
+        if (!dist.Gather(&error)) {
+            std::fprintf(stderr, "node %d: gather failed: %s\n", dist.Rank(), error.c_str());
+            return 1;
+        }
+        if (dist.Rank() == 0) std::printf("world gathered: %dx%d, alive %d\n", world.w, world.h, (int)aliveCount);
+        else std::printf("strip sent to node 0\n");
+    }
+    // Мир целиком есть только у узла 0: сумма и сохранение - там
+    const bool wholeWorld = !distributed || dist.Rank() == 0;
+    if (replayRecorder && opts.seek >= 0) {
+        std::string error;
+        auto seekStart = Clock::now();
+        if (replay.Seek((unsigned)opts.seek, &error)) {
+            std::printf("seek to tick %u in %.1f ms, alive %d\n", worldTick, ms(Clock::now() - seekStart), (int)aliveCount);
+        } else {
+            std::fprintf(stderr, "seek failed: %s\n", error.c_str());
+        }
+    }
+    if (replayRecorder) {
+        replayRecorder = nullptr;
+        replay.Close();
+        std::printf("replay saved to %s: ticks [%u, %u), %d keyframes (%lld ticks dropped)\n", replay.Dir().c_str(),
+                    replay.FirstTick(), replay.EndTick(), replay.Keyframes(), replay.Dropped());
+    }
+    if (statsRecorder) {
+        statsRecorder = nullptr;
+        recorder.Close();
+        std::printf("stats saved to %s (%lld ticks dropped)\n", recorder.Path().c_str(), recorder.Dropped());
+    }
+    if (wholeWorld) std::printf("checksum %016llx\n", (unsigned long long)WorldChecksum());
+    if (vmMode == VM_MODE_CHECK) std::printf("vm check: %lld mismatches\n", (long long)vmCheckMismatches);
+
+    // Разбивка по фазам: перцентили по последним Profiler::WINDOW тикам
+    std::printf("%-12s %10s %10s %10s %10s %10s\n", "phase", "mean ms", "p50", "p95", "p99", "max");
+    for (int p = 0; p < PROF_COUNT; p++) {
+        ProfStats s = profiler.Phase((ProfPhase)p);
+        if (s.count == 0) continue;
+        std::printf("%-12s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                    PROF_PHASE_NAMES[p], s.mean, s.p50, s.p95, s.p99, s.max);
+    }
+    std::vector<ProfStats> workers = profiler.Workers();
+    for (size_t i = 0; i < workers.size(); i++) {
+        std::printf("worker %-5zu busy %5.1f%%  idle %5.1f%%\n", i, workers[i].mean, 100.0 - workers[i].mean);
+    }
+    if (opts.save && wholeWorld) {
+        std::string error;
+        auto saveStart = Clock::now();
+        if (SaveWorld(opts.save, opts.compress, &error)) {
+            std::printf("world saved to %s in %.1f ms%s\n", opts.save, ms(Clock::now() - saveStart),
+                        opts.compress && !SaveCompressionAvailable() ? " (uncompressed: built without zstd)" : "");
+        } else {
+            std::fprintf(stderr, "cannot save %s: %s\n", opts.save, error.c_str());
+        }
+    }
+    if (opts.profile) {
+        if (profiler.Write(opts.profile, RunDescription())) std::printf("profile saved to %s\n", opts.profile);
+        else std::fprintf(stderr, "cannot write profile %s\n", opts.profile);
+    }
+    return 0;
+}
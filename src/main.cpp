@@ -1,250 +1,654 @@
 #include "raylib.h"
 #include "raymath.h"
-#include <vector>
-#include <thread>
-#include <atomic>
-#include <random>
+#include "rlgl.h"
 #include <algorithm>
-
-// --- КОНСТАНТЫ МИРА ---
-const int WORLD_W = 256; // 256 * 128 = 32,768 клеток (хватит для 10k ботов)
-const int WORLD_H = 128;
-const int GENOME_SIZE = 64;
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "power.h"
+#include "profiler.h"
+#include "replay.h"
+#include "save.h"
+#include "sim.h"
+#include "sim_thread.h"
+#include "stats.h"
+#if defined(ALIFE_GPU)
+#include "gpu_sim.h"
+#endif
+
+#if defined(PLATFORM_ANDROID)
+#include <dlfcn.h>
+#include <jni.h>
+#include <android_native_app_glue.h>
+extern "C" struct android_app* GetAndroidApp(void); // Экспортируется raylib (rcore_android)
+
+// Extras интента запуска, например:
+// adb shell am start -n com.example.alifesim/android.app.NativeActivity --ei width 1024 --ei height 512
+void LoadIntentExtras(SimConfig& cfg) {
+    android_app* app = GetAndroidApp();
+    if (!app || !app->activity) return;
+    JavaVM* vm = app->activity->vm;
+    JNIEnv* env = nullptr;
+    if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) return;
+
+    jobject activity = app->activity->clazz;
+    jclass activityClass = env->GetObjectClass(activity);
+    jmethodID getIntent = env->GetMethodID(activityClass, "getIntent", "()Landroid/content/Intent;");
+    jobject intent = env->CallObjectMethod(activity, getIntent);
+    if (intent) {
+        jclass intentClass = env->GetObjectClass(intent);
+        jmethodID getIntExtra = env->GetMethodID(intentClass, "getIntExtra", "(Ljava/lang/String;I)I");
+        jmethodID getBoolExtra = env->GetMethodID(intentClass, "getBooleanExtra", "(Ljava/lang/String;Z)Z");
+        auto intExtra = [&](const char* name, int fallback) {
+            jstring key = env->NewStringUTF(name);
+            int v = env->CallIntMethod(intent, getIntExtra, key, fallback);
+            env->DeleteLocalRef(key);
+            return v;
+        };
+        cfg.worldW = intExtra("width", cfg.worldW);
+        cfg.worldH = intExtra("height", cfg.worldH);
+        cfg.genomeSize = intExtra("genome", cfg.genomeSize);
+        cfg.threads = intExtra("threads", cfg.threads);
+        cfg.seed = (unsigned)intExtra("seed", (int)cfg.seed);
+        cfg.perf = intExtra("perf", cfg.perf); // PerfMode: 0 - battery, 1 - balanced, 2 - max
+        jstring pinKey = env->NewStringUTF("pin");
+        cfg.pinBigCores = env->CallBooleanMethod(intent, getBoolExtra, pinKey, (jboolean)cfg.pinBigCores);
+        env->DeleteLocalRef(pinKey);
+        env->DeleteLocalRef(intentClass);
+        env->DeleteLocalRef(intent);
+    }
+    env->DeleteLocalRef(activityClass);
+    vm->DetachCurrentThread();
+}
+#endif
 
 // Цвета для быстрого доступа
 const Color COLOR_EMPTY = {10, 10, 10, 255};
 const Color COLOR_ORGANIC = {40, 30, 10, 255};
 const Color COLOR_BOT = {0, 255, 0, 255};
 
-struct Bot {
-    bool alive = false;
-    unsigned char genome[GENOME_SIZE];
-    unsigned char ip = 0;       // Instruction Pointer
-    unsigned char dir = 0;      // 0-7 directions
-    int energy = 0;
-    Color color = COLOR_BOT;
-};
+// Палитра по индексу BotColor
+const Color BOT_PALETTE[] = { COLOR_BOT, {150, 0, 0, 255} };
+
+// --- ПАЛИТРЫ РЕЖИМОВ ПРОСМОТРА ---
+// Строка VIEW_ORGANIC - градиент органики (им рисуются пустые клетки в любом режиме),
+// остальные - цвет бота по второму байту клетки. Последняя строка текстуры палитр - BOT_PALETTE.
+// Одни и те же таблицы использует и CPU-раскраска, и шейдер.
+const int PALETTE_ROWS = VIEW_COUNT + 1;
+Color viewPalette[VIEW_COUNT][256];
 
-// Ячейка мира
-struct Cell {
-    Bot bot;
-    int organic = 0; // Органическое вещество (еда)
+Color LerpColor(Color a, Color b, float t) {
+    return (Color){ (unsigned char)(a.r + (b.r - a.r) * t), (unsigned char)(a.g + (b.g - a.g) * t),
+                    (unsigned char)(a.b + (b.b - a.b) * t), 255 };
+}
+
+// Градиент по опорным цветам, равномерно разнесённым по 0-255
+Color Gradient(const Color* stops, int count, int v) {
+    float pos = v / 255.0f * (count - 1);
+    int k = std::min((int)pos, count - 2);
+    return LerpColor(stops[k], stops[k + 1], pos - k);
+}
+
+void BuildPalettes() {
+    const Color heat[] = { {40, 0, 60, 255}, {200, 0, 0, 255}, {255, 200, 0, 255}, {255, 255, 255, 255} };
+    const Color age[] = { {0, 60, 255, 255}, {0, 220, 220, 255}, {255, 255, 255, 255} };
+    for (int v = 0; v < 256; v++) {
+        int org = std::min(v * 2, 255);
+        viewPalette[VIEW_ORGANIC][v] = (Color){ (unsigned char)org, (unsigned char)(org / 2), 0, 255 };
+        viewPalette[VIEW_ENERGY][v] = Gradient(heat, 4, v);
+        // Соседние хеши - далёкие оттенки: 97 взаимно просто с 256
+        viewPalette[VIEW_GENOME][v] = ColorFromHSV((float)(v * 97 % 256) * 360.0f / 256.0f, 0.85f, 1.0f);
+        viewPalette[VIEW_AGE][v] = Gradient(age, 3, v);
+    }
+}
+
+// --- GPU-РАСКРАСКА ---
+// Вместо RGBA в текстуру уходит сам снимок: 2 байта на клетку (GRAY_ALPHA: .r - тип, .a - значение),
+// цвет по палитре считает фрагментный шейдер. Заливка вдвое меньше, а смена режима просмотра
+// - только смена строки палитры.
+#if defined(PLATFORM_ANDROID)
+const char* PALETTE_SHADER_PRELUDE = R"(#version 100
+precision mediump float;
+varying vec2 fragTexCoord;
+varying vec4 fragColor;
+#define TEXTURE texture2D
+#define FRAG_COLOR gl_FragColor
+)";
+#else
+const char* PALETTE_SHADER_PRELUDE = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+out vec4 finalColor;
+#define TEXTURE texture
+#define FRAG_COLOR finalColor
+)";
+#endif
+
+// Общая часть шейдеров раскраски
+const char* PALETTE_SHADER_COMMON = R"(
+uniform sampler2D texture0; // Снимок (уровень 0) или LOD-уровень
+uniform sampler2D palette;  // 256 x PALETTE_ROWS
+uniform vec4 colDiffuse;
+uniform float view;
+
+vec4 PaletteAt(float index, float row) {
+    return TEXTURE(palette, vec2((index + 0.5) / 256.0, (row + 0.5) / PALETTE_ROWS));
+}
+
+float Byte(float v) { return floor(v * 255.0 + 0.5); }
+)";
+
+// Уровень 0: .r - SnapshotCell, .a - органика или значение view
+const char* CELL_SHADER_MAIN = R"(
+void main() {
+    vec4 cell = TEXTURE(texture0, fragTexCoord);
+    float type = Byte(cell.r);
+    float value = Byte(cell.a);
+    vec4 c;
+    if (type < 0.5) c = PaletteAt(value, 0.0);
+    else if (view < 0.5) c = PaletteAt(type - 1.0, PALETTE_ROWS - 1.0);
+    else c = PaletteAt(value, view);
+    FRAG_COLOR = c * colDiffuse * fragColor;
+}
+)";
+
+// LOD: LodTexel (density, green, value, organic) - цвет ботов поверх органики по плотности
+const char* LOD_SHADER_MAIN = R"(
+void main() {
+    vec4 t = TEXTURE(texture0, fragTexCoord);
+    vec4 ground = PaletteAt(Byte(t.a), 0.0);
+    vec4 bot;
+    if (view < 0.5) bot = PaletteAt(Byte(t.g) >= 128.0 ? 0.0 : 1.0, PALETTE_ROWS - 1.0);
+    else bot = PaletteAt(Byte(t.b), view);
+    FRAG_COLOR = mix(ground, bot, t.r) * colDiffuse * fragColor;
+}
+)";
+
+// --- УРОВНИ ОТРИСОВКИ ---
+// Уровень 0 - тексель на клетку, уровень L - LOD-тексель на 2^L x 2^L клеток (SimSnapshot::lods).
+// Рисуется уровень, где тексель не мельче пикселя экрана, поэтому работа на кадр ограничена
+// размером экрана, а не мира. Уровни, не влезающие в лимит текстур, не создаются вовсе.
+#if defined(PLATFORM_ANDROID)
+const int MAX_TEXTURE_SIDE = 4096; // Держат все мобильные GPU, которые мы поддерживаем
+#else
+const int MAX_TEXTURE_SIDE = 16384;
+#endif
+
+struct RenderLevel {
+    int w = 0, h = 0;                   // В текселях
+    Image pixels = { 0 };               // RGBA для CPU-раскраски
+    Texture2D rgba = { 0 };
+    Texture2D state = { 0 };            // Байты снимка как есть для шейдера
+    std::vector<unsigned> drawnVersion; // Версия снимка, из которой нарисован каждый блок; 0 - не нарисован
+    SnapshotView drawnView = VIEW_ORGANIC;
 };
 
-// Два буфера для симуляции (Current и Next)
-std::vector<Cell> gridA(WORLD_W * WORLD_H);
-std::vector<Cell> gridB(WORLD_W * WORLD_H);
-Cell* currentGrid = gridA.data();
-Cell* nextGrid = gridB.data();
+std::vector<RenderLevel> renderLevels; // Индекс - уровень
+int minRenderLevel = 0;                // Самый детальный уровень, влезающий в MAX_TEXTURE_SIDE
+int renderLevelBias = 0;               // PerfSettings::renderLevelBias: рисовать на столько уровней грубее
+int shownLevel = -1;                   // Уровень, нарисованный в прошлом кадре
 
-// Текстура для рендеринга
-Image screenImage;
-Texture2D screenTexture;
+Texture2D paletteTexture;
+Shader cellShader, lodShader;
+bool paletteShaderReady = false;
+bool gpuColorize = false;  // C - раскраска шейдером / на CPU
 Camera2D camera = { 0 };
 
-// Статистика
-std::atomic<int> aliveCount{0};
+Shader LoadPaletteShader(const char* body) {
+    std::string fs = std::string(PALETTE_SHADER_PRELUDE) + "#define PALETTE_ROWS " + std::to_string(PALETTE_ROWS) + ".0\n" +
+                     PALETTE_SHADER_COMMON + body;
+    return LoadShaderFromMemory(nullptr, fs.c_str());
+}
 
-// Смещения для 8 направлений
-const int DIR_X[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
-const int DIR_Y[] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+void LoadRenderer() {
+    int levels = LodLevelCount(world.w, world.h);
+    renderLevels.assign(levels + 1, RenderLevel());
+    for (int level = 0; level <= levels; level++) {
+        renderLevels[level].w = LodSide(world.w, level);
+        renderLevels[level].h = LodSide(world.h, level);
+    }
+    minRenderLevel = 0;
+    while (minRenderLevel < levels && std::max(renderLevels[minRenderLevel].w, renderLevels[minRenderLevel].h) > MAX_TEXTURE_SIDE) {
+        minRenderLevel++;
+    }
 
-// --- ГЕНЕРАЦИЯ ---
-void InitWorld() {
-    std::mt19937 rng(12345);
-    std::uniform_int_distribution<int> byteDist(0, 255);
-    
-    for (int i = 0; i < WORLD_W * WORLD_H; i++) {
-        currentGrid[i].organic = byteDist(rng) % 50; // Немного органики везде
-        
-        // Спавним ботов (примерно 20% заполнения)
-        if (byteDist(rng) > 200) {
-            currentGrid[i].bot.alive = true;
-            currentGrid[i].bot.energy = 500;
-            currentGrid[i].bot.dir = byteDist(rng) % 8;
-            for (int g = 0; g < GENOME_SIZE; g++) {
-                currentGrid[i].bot.genome[g] = byteDist(rng);
-            }
-        }
+    BuildPalettes();
+    std::vector<Color> rows((size_t)256 * PALETTE_ROWS, BLACK);
+    for (int v = 0; v < VIEW_COUNT; v++) std::copy_n(viewPalette[v], 256, rows.data() + (size_t)v * 256);
+    std::copy_n(BOT_PALETTE, 2, rows.data() + (size_t)VIEW_COUNT * 256);
+    Image palette = { rows.data(), 256, PALETTE_ROWS, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    paletteTexture = LoadTextureFromImage(palette);
+
+    cellShader = LoadPaletteShader(CELL_SHADER_MAIN);
+    lodShader = LoadPaletteShader(LOD_SHADER_MAIN);
+    // Не собрался - raylib подставляет шейдер по умолчанию; остаётся CPU-раскраска
+    paletteShaderReady = cellShader.id != rlGetShaderIdDefault() && lodShader.id != rlGetShaderIdDefault();
+    gpuColorize = paletteShaderReady;
+}
+
+// Текстуры уровня создаются при первом использовании: на большом мире детальные уровни
+// могут не понадобиться вовсе
+void EnsureLevelTextures(int level) {
+    RenderLevel& target = renderLevels[level];
+    if (gpuColorize && target.state.id == 0) {
+        int bytes = level == 0 ? 2 : (int)sizeof(LodTexel);
+        std::vector<unsigned char> empty((size_t)target.w * target.h * bytes, 0);
+        Image state = { empty.data(), target.w, target.h, 1,
+                        level == 0 ? PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA : PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        target.state = LoadTextureFromImage(state);
+    }
+    if (!gpuColorize && target.rgba.id == 0) {
+        target.pixels = GenImageColor(target.w, target.h, BLACK);
+        target.rgba = LoadTextureFromImage(target.pixels);
     }
 }
 
-// --- ВИРТУАЛЬНАЯ МАШИНА (ЛОГИКА БОТА) ---
-void ProcessBot(int idx, Cell* readGrid, Cell* writeGrid) {
-    Cell& cell = readGrid[idx];
-    Bot& bot = cell.bot;
-    
-    // Если бот мертв, превращаем в органику
-    if (bot.energy <= 0) {
-        writeGrid[idx].organic += 50; // Труп разлагается
-        writeGrid[idx].bot.alive = false;
+void UnloadRenderer() {
+    if (paletteShaderReady) {
+        UnloadShader(cellShader);
+        UnloadShader(lodShader);
+    }
+    for (RenderLevel& target : renderLevels) {
+        if (target.state.id) UnloadTexture(target.state);
+        if (target.rgba.id) UnloadTexture(target.rgba);
+        if (target.pixels.data) UnloadImage(target.pixels);
+    }
+    renderLevels.clear();
+    UnloadTexture(paletteTexture);
+}
+
+#if defined(ALIFE_GPU)
+// GPU-бэкенд раскрашивает сразу в RGBA-текстуру уровня 0
+Texture2D GpuBackendTexture() {
+    RenderLevel& target = renderLevels[0];
+    if (target.rgba.id == 0) {
+        target.pixels = GenImageColor(target.w, target.h, BLACK);
+        target.rgba = LoadTextureFromImage(target.pixels);
+    }
+    return target.rgba;
+}
+#endif
+
+// Уровень по зуму: тексель (2^L клеток) не мельче пикселя
+int LevelForZoom(float zoom) {
+    int level = 0;
+    while (level + 1 < (int)renderLevels.size() && (float)(1 << level) * zoom < 1.0f) level++;
+    level = std::min(level + renderLevelBias, (int)renderLevels.size() - 1);
+    return std::max(level, minRenderLevel);
+}
+
+void DrawWorldTexture() {
+    if (shownLevel < 0) return;
+    const RenderLevel& target = renderLevels[shownLevel];
+    Vector2 origin = { 0, 0 };
+    float scale = (float)(1 << shownLevel);
+    if (!gpuColorize) {
+        DrawTextureEx(target.rgba, origin, 0.0f, scale, WHITE);
         return;
     }
+    Shader shader = shownLevel == 0 ? cellShader : lodShader;
+    float row = (float)target.drawnView;
+    BeginShaderMode(shader);
+        SetShaderValueTexture(shader, GetShaderLocation(shader, "palette"), paletteTexture);
+        SetShaderValue(shader, GetShaderLocation(shader, "view"), &row, SHADER_UNIFORM_FLOAT);
+        DrawTextureEx(target.state, origin, 0.0f, scale, WHITE);
+    EndShaderMode();
+}
 
-    // Копируем состояние бота в следующий кадр (по умолчанию он остается здесь)
-    writeGrid[idx].bot = bot; 
-    Bot& nextBot = writeGrid[idx].bot;
+// Симуляция работает в своём потоке; рендер видит мир только через снимки
+SimThread simThread;
+
+// F5 - сохранение в фоне (копия мира снимается в потоке симуляции), F9 - загрузка
+SaveWriter saveWriter;
+
+#if defined(ALIFE_GPU)
+// G - переключение тика на GPU и обратно. Пока работает GPU, поток симуляции стоит,
+// а тики и раскраска идут в этом потоке (здесь живёт GL-контекст). Только при уровне 0.
+GpuSim gpuSim;
+#endif
+
+// --- ЖИЗНЕННЫЙ ЦИКЛ И ТЕПЛО ---
+// Свёрнутое приложение не тратит батарею: на APP_CMD_PAUSE поток симуляции останавливается
+// (мир остаётся в памяти как есть), на APP_CMD_RESUME запускается с тем же темпом.
+// Тепловой статус - AThermal (API 30+, ищется через dlsym: minSdk ниже); на ПК и старых
+// Android его нет - THERMAL_NONE.
+std::atomic<int> thermalStatus{THERMAL_NONE};
+
+int ThermalStatus() { return thermalStatus.load(std::memory_order_relaxed); }
+
+#if defined(PLATFORM_ANDROID)
+struct AThermalManager;
+typedef AThermalManager* (*AThermalAcquireFn)();
+typedef int (*AThermalStatusFn)(AThermalManager*);
+typedef int (*AThermalRegisterFn)(AThermalManager*, void (*)(void*, int), void*);
+
+// Слушатель вызывается в binder-потоке: только сохраняем статус, главный цикл применит его сам
+void StartThermalMonitor() {
+    void* lib = dlopen("libandroid.so", RTLD_NOW);
+    if (!lib) return;
+    auto acquire = (AThermalAcquireFn)dlsym(lib, "AThermal_acquireManager");
+    auto current = (AThermalStatusFn)dlsym(lib, "AThermal_getCurrentThermalStatus");
+    auto listen = (AThermalRegisterFn)dlsym(lib, "AThermal_registerThermalStatusListener");
+    if (!acquire || !current) return;
+    AThermalManager* manager = acquire(); // Живёт до конца процесса
+    if (!manager) return;
+    thermalStatus = current(manager);
+    if (listen) listen(manager, [](void*, int status) { thermalStatus = status; }, nullptr);
+}
 
-    // Лимит выполнения команд за ход (чтобы не завис в бесконечном цикле)
-    int commandsExecuted = 0;
-    bool turnEnded = false;
+void (*raylibOnAppCmd)(android_app*, int32_t) = nullptr;
+bool resumeSimThread = false; // Поток остановлен паузой приложения (а не загрузкой или GPU-бэкендом)
+
+// Команды приходят в главном потоке изнутри опроса событий raylib, пока главный цикл
+// стоит - поэтому поток симуляции останавливается здесь, а не в цикле
+void OnAppCmd(android_app* app, int32_t cmd) {
+    if (cmd == APP_CMD_PAUSE && simThread.Running()) {
+        simThread.Stop();
+        resumeSimThread = true;
+    } else if (cmd == APP_CMD_RESUME && resumeSimThread) {
+        simThread.Start(simThread.TickRate(), simThread.TicksPerFrame());
+        resumeSimThread = false;
+    }
+    if (raylibOnAppCmd) raylibOnAppCmd(app, cmd);
+}
 
-    while (commandsExecuted < 10 && !turnEnded) {
-        unsigned char cmd = bot.genome[nextBot.ip];
-        nextBot.ip = (nextBot.ip + 1) % GENOME_SIZE; // Сдвиг указателя
+void HookAppLifecycle() {
+    android_app* app = GetAndroidApp();
+    if (!app || app->onAppCmd == OnAppCmd) return;
+    raylibOnAppCmd = app->onAppCmd;
+    app->onAppCmd = OnAppCmd;
+}
+#endif
 
-        // Интерпретация команд (упрощенная)
-        // 0-7: Сдвиг IP (безусловный переход)
-        if (cmd < 8) {
-            nextBot.ip = (nextBot.ip + cmd) % GENOME_SIZE;
-        }
-        // 10-15: Поворот
-        else if (cmd >= 10 && cmd <= 15) {
-            nextBot.dir = (nextBot.dir + (cmd - 10)) % 8;
-        }
-        // 20: Фотосинтез
-        else if (cmd == 20) {
-            nextBot.energy += 5; // Получаем энергию от солнца
-            nextBot.color = {0, 255, 0, 255}; // Зеленеем
-            turnEnded = true;
-        }
-        // 30: Поедание органики под собой
-        else if (cmd == 30) {
-            if (readGrid[idx].organic > 0) {
-                int eat = std::min(readGrid[idx].organic, 20);
-                nextBot.energy += eat;
-                writeGrid[idx].organic -= eat; // Внимание: тут возможна гонка при многопоточности, но для organic это не критично в визуализации
-                nextBot.color = {150, 0, 0, 255}; // Краснеем
-            }
-            turnEnded = true;
+// --- ОТРИСОВКА ---
+// Тексели пересчитываются и заливаются только для видимых блоков, изменившихся с прошлой
+// отрисовки уровня (SimSnapshot::blockVersion). Невидимые блоки догоняются, когда попадут в кадр.
+std::vector<unsigned char> uploadScratch; // Упаковка неполных по ширине прямоугольников для UpdateTextureRec
+
+unsigned drawFromSeq = 0;            // Снимки старше этого не рисуются
+
+// Текстура перезаписана в обход снимков или сменился способ раскраски: всё перерисовать,
+// начиная со снимка firstSeq (GPU-бэкенд - со следующего, прежний снимок устарел)
+void InvalidateDrawnBlocks(unsigned firstSeq = 0) {
+    for (RenderLevel& target : renderLevels) target.drawnVersion.clear();
+    drawFromSeq = firstSeq;
+}
+
+struct DirtyRun { int by, bx0, bx1; }; // Подряд идущие грязные блоки одной строки: [bx0, bx1)
+
+// Прямоугольники блоков из src (bytesPerPixel на тексель, раскладка как у уровня) - в текстуру
+void UploadRuns(Texture2D texture, const unsigned char* src, int bytesPerPixel, const std::vector<DirtyRun>& runs,
+                int w, int h) {
+    for (const DirtyRun& run : runs) {
+        int rx = run.bx0 * RENDER_BLOCK, rw = std::min(run.bx1 * RENDER_BLOCK, w) - rx;
+        int ry = run.by * RENDER_BLOCK, rh = std::min(ry + RENDER_BLOCK, h) - ry;
+        Rectangle rect = { (float)rx, (float)ry, (float)rw, (float)rh };
+        // Полные строки лежат подряд, остальное упаковываем
+        if (rw == w) {
+            UpdateTextureRec(texture, rect, src + (size_t)ry * w * bytesPerPixel);
+            continue;
         }
-        // 40: Движение / Атака
-        else if (cmd == 40) {
-            int dx = DIR_X[nextBot.dir];
-            int dy = DIR_Y[nextBot.dir];
-            
-            // Тороидальный мир (зацикленный)
-            int nx = (idx % WORLD_W + dx + WORLD_W) % WORLD_W;
-            int ny = (idx / WORLD_W + dy + WORLD_H) % WORLD_H;
-            int nIdx = ny * WORLD_W + nx;
-
-            if (readGrid[nIdx].bot.alive) {
-                // Атака соседа (хищничество)
-                nextBot.energy += readGrid[nIdx].bot.energy / 2;
-                // Сосед умирает в следующем кадре (мы его "перезаписываем" пустым или убитым, 
-                // но в double buffer сложно убить соседа мгновенно. 
-                // Упрощение: просто получаем энергию, сосед умрет от голода или мы его съедим как органику позже)
-            } else {
-                // Движение: перемещаемся в свободную клетку
-                // Проверяем, не занята ли клетка в writeGrid (кто-то уже сходил туда?)
-                // Для простоты и скорости lock-free: если клетка пуста в readGrid, идем.
-                // Коллизии решаются приоритетом (кто первый обработался).
-                if (!writeGrid[nIdx].bot.alive) {
-                    writeGrid[nIdx].bot = nextBot; // Переносим бота
-                    writeGrid[idx].bot.alive = false; // Освобождаем старую
-                    nextBot.energy -= 2; // Трата на движение
-                }
-            }
-            turnEnded = true;
+        const size_t rowBytes = (size_t)rw * bytesPerPixel;
+        uploadScratch.resize(rowBytes * rh);
+        for (int y = 0; y < rh; y++) {
+            std::copy_n(src + ((size_t)(ry + y) * w + rx) * bytesPerPixel, rowBytes, uploadScratch.data() + y * rowBytes);
         }
-        
-        commandsExecuted++;
+        UpdateTextureRec(texture, rect, uploadScratch.data());
     }
+}
 
-    nextBot.energy -= 1; // Трата на существование
+Color LodColor(const LodTexel& t, SnapshotView view) {
+    Color ground = viewPalette[VIEW_ORGANIC][t.organic];
+    Color bot = view == VIEW_ORGANIC ? BOT_PALETTE[t.green >= 128 ? BOT_COLOR_GREEN : BOT_COLOR_RED] : viewPalette[view][t.value];
+    return LerpColor(ground, bot, t.density / 255.0f);
 }
 
-// --- ОБНОВЛЕНИЕ МИРА (МНОГОПОТОЧНОЕ) ---
-void UpdateWorld() {
-    aliveCount = 0;
+// Заказать у потока симуляции LOD-уровни, нужные для зума
+void RequestLodLevels(int level) {
+    static int requested = 0;
+    if (level == requested) return;
+    requested = level;
+    simThread.Post([level] { snapshotLodLevels = level; });
+}
 
-    // Очищаем nextGrid от ботов (органика остается, копируем её или накапливаем)
-    // Для оптимизации просто копируем органику, а ботов обнуляем перед записью?
-    // Нет, самый быстрый способ:
-    // Мы бежим по ReadGrid. Если там бот -> обрабатываем и пишем в WriteGrid.
-    // Если там пусто -> просто копируем уровень органики.
-    
-    // Предварительная очистка WriteGrid для ботов (важно для логики перемещения)
-    // На мобильных лучше делать это чанками, но `memset` очень быстр.
-    // Однако, нам нужно сохранить органику.
-    
-    // Упрощенная многопоточность: делим экран на 4 полосы
-    int threadsCount = std::thread::hardware_concurrency();
-    if (threadsCount == 0) threadsCount = 4;
-    
-    std::vector<std::thread> workers;
-    int chunkSize = (WORLD_W * WORLD_H) / threadsCount;
+// Сообщить потоку симуляции видимую часть мира в клетках: снимок пакует только её
+void RequestVisibleCells(int x0, int y0, int x1, int y1) {
+    static SnapshotRect requested;
+    if (x0 == requested.x0 && y0 == requested.y0 && x1 == requested.x1 && y1 == requested.y1) return;
+    requested = { x0, y0, x1, y1 };
+    SnapshotRect rect = requested;
+    simThread.Post([rect] { snapshotVisible = rect; });
+}
 
-    // Сначала очищаем слой ботов в буфере записи (чтобы избежать дублей при движении)
-    // В реальном high-performance коде это делают умнее, но здесь memset подойдет
-    // memset(nextGrid, 0, sizeof(Cell) * WORLD_W * WORLD_H); <- Нельзя, удалит органику.
-    
-    // Этап 0: Подготовка сетки (быстрое обнуление флагов живых ботов в целевой сетке)
-    // Для демо сделаем однопоточно, это очень быстро.
-    for(int i=0; i<WORLD_W*WORLD_H; i++) {
-        nextGrid[i].bot.alive = false; 
-        nextGrid[i].organic = currentGrid[i].organic; // Копируем органику
+void DrawWorld(const SimSnapshot& snap) {
+    if (renderLevels.empty() || snap.w != world.w || snap.h != world.h) return;
+    if (snap.seq < drawFromSeq) return;
+
+    // Нужного уровня в снимке может ещё не быть (заказан только что) - берём детальнее, если можно
+    int wanted = LevelForZoom(camera.zoom);
+    RequestLodLevels(wanted);
+    int level = std::min(wanted, (int)snap.lods.size());
+    if (level < minRenderLevel) return;
+    shownLevel = level;
+    EnsureLevelTextures(level);
+    RenderLevel& target = renderLevels[level];
+
+    const int span = 1 << level; // Блоков уровня 0 на блок уровня по оси
+    const int blocksX = (target.w + RENDER_BLOCK - 1) / RENDER_BLOCK;
+    const int blocksY = (target.h + RENDER_BLOCK - 1) / RENDER_BLOCK;
+    // Одни и те же байты в другом режиме - другой цвет
+    if (snap.view != target.drawnView) {
+        target.drawnVersion.clear();
+        target.drawnView = snap.view;
     }
-
-    auto workerFunc = [&](int start, int end) {
-        int localAlive = 0;
-        for (int i = start; i < end; i++) {
-            if (currentGrid[i].bot.alive) {
-                ProcessBot(i, currentGrid, nextGrid);
-                localAlive++;
-            } else {
-                // Прирост органики случайно
-                if (GetRandomValue(0, 1000) > 999) nextGrid[i].organic += 10;
+    if (target.drawnVersion.size() != (size_t)blocksX * blocksY) target.drawnVersion.assign((size_t)blocksX * blocksY, 0);
+
+    // Видимая область в текселях уровня (текстура нарисована в (0,0), тексель = 2^level клеток)
+    Vector2 a = GetScreenToWorld2D({ 0, 0 }, camera);
+    Vector2 b = GetScreenToWorld2D({ (float)GetScreenWidth(), (float)GetScreenHeight() }, camera);
+    float texel = (float)(1 << level);
+    int x0 = std::max(0, (int)std::floor(std::min(a.x, b.x) / texel));
+    int y0 = std::max(0, (int)std::floor(std::min(a.y, b.y) / texel));
+    int x1 = std::min(target.w, (int)std::ceil(std::max(a.x, b.x) / texel));
+    int y1 = std::min(target.h, (int)std::ceil(std::max(a.y, b.y) / texel));
+    RequestVisibleCells(x0 << level, y0 << level, x1 << level, y1 << level);
+    if (x0 >= x1 || y0 >= y1) return;
+    int bx0 = x0 / RENDER_BLOCK, bx1 = (x1 - 1) / RENDER_BLOCK;
+    int by0 = y0 / RENDER_BLOCK, by1 = (y1 - 1) / RENDER_BLOCK;
+
+    // Версия блока уровня - самая свежая из накрытых им блоков уровня 0
+    auto blockVersion = [&](int bx, int by) {
+        unsigned v = 0;
+        for (int y = by * span; y < std::min((by + 1) * span, snap.blocksY); y++) {
+            for (int x = bx * span; x < std::min((bx + 1) * span, snap.blocksX); x++) {
+                v = std::max(v, snap.blockVersion[(size_t)y * snap.blocksX + x]);
             }
         }
-        aliveCount += localAlive;
+        return v;
     };
 
-    for (int i = 0; i < threadsCount; i++) {
-        int start = i * chunkSize;
-        int end = (i == threadsCount - 1) ? (WORLD_W * WORLD_H) : (start + chunkSize);
-        workers.emplace_back(workerFunc, start, end);
+    std::vector<DirtyRun> runs;
+    for (int by = by0; by <= by1; by++) {
+        int runStart = -1;
+        for (int bx = bx0; bx <= bx1 + 1; bx++) {
+            bool dirty = false;
+            if (bx <= bx1) {
+                unsigned& drawn = target.drawnVersion[(size_t)by * blocksX + bx];
+                unsigned version = blockVersion(bx, by);
+                dirty = version > drawn;
+                if (dirty) drawn = version;
+            }
+            if (dirty) {
+                if (runStart < 0) runStart = bx;
+            } else if (runStart >= 0) {
+                runs.push_back({ by, runStart, bx });
+                runStart = -1;
+            }
+        }
     }
+    if (runs.empty()) return;
 
-    for (auto& t : workers) t.join();
+    const unsigned char* bytes = level == 0 ? snap.cells.data() : (const unsigned char*)snap.lods[level - 1].data();
+    if (gpuColorize) {
+        ProfScope scope(PROF_UPLOAD);
+        UploadRuns(target.state, bytes, level == 0 ? 2 : (int)sizeof(LodTexel), runs, target.w, target.h);
+        return;
+    }
 
-    // Меняем буферы местами
-    std::swap(currentGrid, nextGrid);
+    // Прямой доступ к пикселям быстрее, чем DrawPixel
+    Color* pixels = (Color*)target.pixels.data;
+    const Color* organic = viewPalette[VIEW_ORGANIC];
+    const Color* bots = snap.view == VIEW_ORGANIC ? nullptr : viewPalette[snap.view];
+    {
+        ProfScope scope(PROF_DRAW_PIXELS);
+        for (const DirtyRun& run : runs) {
+            int cx0 = run.bx0 * RENDER_BLOCK, cx1 = std::min(run.bx1 * RENDER_BLOCK, target.w);
+            int cy0 = run.by * RENDER_BLOCK, cy1 = std::min(cy0 + RENDER_BLOCK, target.h);
+            for (int y = cy0; y < cy1; y++) {
+                const int first = y * target.w + cx0, last = y * target.w + cx1;
+                if (level == 0) {
+                    PackCellPixels(bytes, first, last, organic, bots, BOT_PALETTE, pixels);
+                    continue;
+                }
+                for (int i = first; i < last; i++) pixels[i] = LodColor(snap.lods[level - 1][i], snap.view);
+            }
+        }
+    }
+
+    ProfScope scope(PROF_UPLOAD);
+    UploadRuns(target.rgba, (const unsigned char*)pixels, 4, runs, target.w, target.h);
 }
 
-// --- ОТРИСОВКА ---
-void DrawWorld() {
-    Color* pixels = (Color*)screenImage.data;
-    
-    // Прямой доступ к пикселям быстрее, чем DrawPixel
-    for (int i = 0; i < WORLD_W * WORLD_H; i++) {
-        if (currentGrid[i].bot.alive) {
-            pixels[i] = currentGrid[i].bot.color;
-        } else {
-            int org = std::min(currentGrid[i].organic * 2, 255);
-            pixels[i] = (Color){(unsigned char)org, (unsigned char)(org/2), 0, 255};
+// --- ОВЕРЛЕЙ ПРОФАЙЛЕРА ---
+// F3 / двойной тап - показать, F4 / касание тремя пальцами - сохранить CSV и JSON.
+// Перцентили пересчитываются раз в полсекунды: сортировка окна на каждом кадре сама бы мешала замеру.
+struct ProfileOverlay {
+    bool visible = false;
+    int framesUntilRefresh = 0;
+    ProfStats phases[PROF_COUNT];
+    std::vector<ProfStats> workers;
+    std::string status; // Результат последнего экспорта
+    bool threeFingers = false; // Экспорт по касанию, а не на каждом кадре удержания
+
+    void Refresh() {
+        if (--framesUntilRefresh > 0) return;
+        framesUntilRefresh = 30;
+        for (int p = 0; p < PROF_COUNT; p++) phases[p] = profiler.Phase((ProfPhase)p);
+        workers = profiler.Workers();
+    }
+
+    void Draw(int x, int y) const {
+        const int line = 18;
+        int rows = 2 + (int)workers.size() + (status.empty() ? 0 : 1);
+        for (const ProfStats& s : phases) rows += s.count > 0;
+        DrawRectangle(x - 6, y - 4, 420, rows * line + 8, Fade(BLACK, 0.7f));
+
+        DrawText("phase            p50     p95     p99  ms", x, y, 16, YELLOW);
+        y += line;
+        for (int p = 0; p < PROF_COUNT; p++) {
+            const ProfStats& s = phases[p];
+            if (s.count == 0) continue;
+            DrawText(TextFormat("%-14s %7.3f %7.3f %7.3f", PROF_PHASE_NAMES[p], s.p50, s.p95, s.p99), x, y, 16, WHITE);
+            y += line;
+        }
+        DrawText("worker   busy p50   p95   idle p50", x, y, 16, YELLOW);
+        y += line;
+        for (size_t i = 0; i < workers.size(); i++) {
+            DrawText(TextFormat("%-6d %9.0f%% %5.0f%% %9.0f%%", (int)i, workers[i].p50, workers[i].p95, 100.0 - workers[i].p50),
+                     x, y, 16, WHITE);
+            y += line;
         }
+        if (!status.empty()) DrawText(status.c_str(), x, y, 16, GREEN);
     }
-    
-    UpdateTexture(screenTexture, pixels);
+};
+
+// Файлы программы (профиль, сохранение): на Android - во внутреннем каталоге приложения
+std::string DataFilePath(const char* name) {
+#if defined(PLATFORM_ANDROID)
+    android_app* app = GetAndroidApp();
+    if (app && app->activity && app->activity->internalDataPath) {
+        return std::string(app->activity->internalDataPath) + "/" + name;
+    }
+#endif
+    return name;
+}
+
+std::string ExportProfile() {
+    std::string meta = RunDescription();
+    std::string csv = DataFilePath("alife_profile.csv");
+    std::string json = DataFilePath("alife_profile.json");
+    if (!profiler.WriteCsv(csv.c_str(), meta) || !profiler.WriteJson(json.c_str(), meta)) {
+        return "profile export failed: " + csv;
+    }
+    return "saved " + csv + " (+.json)";
 }
 
-int main() {
+int main(int argc, char** argv) {
+#if defined(PLATFORM_ANDROID)
+    LoadIntentExtras(config);
+#endif
+    ParseArgs(config, argc, argv);
+    ClampConfig(config);
+
     // Инициализация окна
     InitWindow(0, 0, "ALife Sim"); // 0,0 для полного экрана на Android
-    SetTargetFPS(60);
+#if defined(PLATFORM_ANDROID)
+    StartThermalMonitor();
+#endif
+
+    // F6 - режим по кругу; нагрев переключает действующий режим сам (см. power.h)
+    PerfMode perfMode = config.perf >= 0 ? (PerfMode)config.perf : DefaultPerfMode();
+    PerfSettings perf = PerfSettingsFor(perfMode, ThermalStatus(), config, ThreadPool::DefaultWorkers());
+    SetTargetFPS(perf.fps);
+    renderLevelBias = perf.renderLevelBias;
 
     InitWorld();
+    workerPool.SetPinBigCores(config.pinBigCores);
+    workerPool.Resize(perf.threads);
+    int shownThreads = workerPool.Size();
+    bool shownPinned = workerPool.PinBigCores();
+    VmMode shownVm = vmMode;
+    int fastForward = config.ticksPerFrame > 0 ? config.ticksPerFrame : 10;
+    int realtimeRate = perf.tickRate > 0 ? perf.tickRate : 60;
 
     // Настройка камеры и текстур
-    screenImage = GenImageColor(WORLD_W, WORLD_H, BLACK);
-    screenTexture = LoadTextureFromImage(screenImage);
+    LoadRenderer();
+    SnapshotView shownView = VIEW_ORGANIC;
     
-    camera.target = { (float)WORLD_W/2.0f, (float)WORLD_H/2.0f };
+    camera.target = { (float)world.w/2.0f, (float)world.h/2.0f };
     camera.offset = { (float)GetScreenWidth()/2.0f, (float)GetScreenHeight()/2.0f };
     camera.rotation = 0.0f;
     camera.zoom = 4.0f;
 
+    StatsRecorder recorder;
+    if (!config.stats.empty() && recorder.Open(DataFilePath(config.stats.c_str()).c_str())) statsRecorder = &recorder;
+    ReplayRecorder replay;
+    if (!config.replay.empty()) {
+        std::string error;
+        if (replay.Open(DataFilePath(config.replay.c_str()), config.replayInterval, config.replayKeyframes, &error)) {
+            replayRecorder = &replay;
+        } else {
+            TraceLog(LOG_WARNING, "replay: %s", error.c_str());
+        }
+    }
+
+    simThread.Start(perf.tickRate, config.ticksPerFrame);
+#if defined(PLATFORM_ANDROID)
+    HookAppLifecycle();
+#endif
+    SimSnapshot hud; // Последние показанные цифры
+    ProfileOverlay overlay;
+    const std::string saveFile = DataFilePath("alife_world.sav");
+    std::string loadStatus;     // Итог последней загрузки (итог записи - у saveWriter)
+    double saveStatusUntil = 0; // Строка статуса сохранения видна несколько секунд
+#if defined(ALIFE_GPU)
+    double gpuTickCarry = 0.0;   // Дробный остаток тиков в режиме заданной частоты
+    double gpuRateStart = GetTime();
+    long long gpuRateTicks = 0;
+    double gpuRate = 0.0;
+#endif
+
     while (!WindowShouldClose()) {
         // --- INPUT (Touch / Mouse) ---
         // Zoom
@@ -261,27 +665,237 @@ int main() {
             camera.target = Vector2Add(camera.target, delta);
         }
         
+        // Число воркеров и привязка к большим ядрам (пул принадлежит потоку симуляции)
+        if (IsKeyPressed(KEY_RIGHT_BRACKET)) shownThreads++;
+        if (IsKeyPressed(KEY_LEFT_BRACKET) && shownThreads > 1) shownThreads--;
+        if (IsKeyPressed(KEY_P)) shownPinned = !shownPinned;
+        if (IsKeyPressed(KEY_RIGHT_BRACKET) || IsKeyPressed(KEY_LEFT_BRACKET) || IsKeyPressed(KEY_P)) {
+            int n = shownThreads;
+            bool pin = shownPinned;
+            simThread.Post([n, pin] { workerPool.SetPinBigCores(pin); workerPool.Resize(n); });
+        }
+
+        // Режим производительности: заново применяется при смене выбора или действующего режима
+        // (нагрев/остывание); ручные настройки потоков и частоты живут до следующей смены
+        if (IsKeyPressed(KEY_F6)) perfMode = (PerfMode)((perfMode + 1) % PERF_MODE_COUNT);
+        PerfSettings wanted = PerfSettingsFor(perfMode, ThermalStatus(), config, ThreadPool::DefaultWorkers());
+        if (IsKeyPressed(KEY_F6) || wanted.mode != perf.mode) {
+            perf = wanted;
+            shownThreads = perf.threads;
+            int n = perf.threads;
+            bool pin = shownPinned;
+            simThread.Post([n, pin] { workerPool.SetPinBigCores(pin); workerPool.Resize(n); });
+            if (perf.tickRate > 0) realtimeRate = perf.tickRate;
+            simThread.SetTickRate(perf.tickRate);
+            SetTargetFPS(perf.fps);
+            renderLevelBias = perf.renderLevelBias;
+        }
+
+        // V - режим VM по кругу: скалярный эталон -> SIMD -> SIMD со сверкой
+        if (IsKeyPressed(KEY_V)) {
+            VmMode next = (VmMode)((shownVm + 1) % (VM_MODE_CHECK + 1));
+            shownVm = next;
+            simThread.Post([next] { vmMode = next; });
+        }
+
+        // M - режим просмотра (органика, энергия, геном, возраст), C - раскраска шейдером или на CPU
+        if (IsKeyPressed(KEY_M)) {
+            SnapshotView next = (SnapshotView)((shownView + 1) % VIEW_COUNT);
+            shownView = next;
+            simThread.Post([next] { snapshotView = next; });
+        }
+        if (IsKeyPressed(KEY_C) && paletteShaderReady) {
+            gpuColorize = !gpuColorize;
+            InvalidateDrawnBlocks();
+        }
+
+        // Скорость: пробел - пауза, 1 - реальное время, 2 - без ограничения, 3 - N тиков на кадр
+        if (IsKeyPressed(KEY_SPACE)) simThread.SetPaused(!simThread.Paused());
+        if (IsKeyPressed(KEY_ONE)) { simThread.SetTicksPerFrame(0); simThread.SetTickRate(realtimeRate); }
+        if (IsKeyPressed(KEY_TWO)) { simThread.SetTicksPerFrame(0); simThread.SetTickRate(0); }
+        if (IsKeyPressed(KEY_THREE)) simThread.SetTicksPerFrame(fastForward);
+        // , и . - вдвое медленнее/быстрее в текущем режиме
+        if (IsKeyPressed(KEY_PERIOD) || IsKeyPressed(KEY_COMMA)) {
+            bool faster = IsKeyPressed(KEY_PERIOD);
+            if (simThread.TicksPerFrame() > 0) {
+                fastForward = faster ? fastForward * 2 : std::max(1, fastForward / 2);
+                simThread.SetTicksPerFrame(fastForward);
+            } else if (simThread.TickRate() > 0) {
+                realtimeRate = faster ? realtimeRate * 2 : std::max(1, realtimeRate / 2);
+                simThread.SetTickRate(realtimeRate);
+            }
+        }
+
+        // Профайлер
+        if (IsKeyPressed(KEY_F3) || IsGestureDetected(GESTURE_DOUBLETAP)) overlay.visible = !overlay.visible;
+        bool threeFingers = GetTouchPointCount() >= 3;
+        if (IsKeyPressed(KEY_F4) || (threeFingers && !overlay.threeFingers)) overlay.status = ExportProfile();
+        overlay.threeFingers = threeFingers;
+
+        // Сохранение и загрузка. Мир, пока работает GPU-бэкенд, живёт в видеопамяти - только на CPU
+        bool cpuBackend = true;
+#if defined(ALIFE_GPU)
+        cpuBackend = !gpuSim.Active();
+#endif
+        if (IsKeyPressed(KEY_F5) && cpuBackend) {
+            simThread.Post([saveFile] { saveWriter.SaveAsync(saveFile, SaveCompressionAvailable()); });
+            loadStatus.clear();
+            saveStatusUntil = GetTime() + 5.0;
+        }
+        if (IsKeyPressed(KEY_F9) && cpuBackend) {
+            simThread.Stop();
+            saveWriter.Wait();
+            int oldW = world.w, oldH = world.h;
+            std::string error;
+            if (LoadWorld(saveFile.c_str(), &error)) {
+                if (world.w != oldW || world.h != oldH) {
+                    UnloadRenderer();
+                    LoadRenderer();
+                    camera.target = { (float)world.w/2.0f, (float)world.h/2.0f };
+                }
+                // Снимки старого мира больше не рисуем
+                simThread.AcquireSnapshot();
+                InvalidateDrawnBlocks(simThread.LatestSnapshot().seq + 1);
+                loadStatus = "loaded " + saveFile;
+            } else {
+                loadStatus = "load failed: " + error;
+            }
+            simThread.Start(simThread.TickRate(), simThread.TicksPerFrame());
+            saveStatusUntil = GetTime() + 5.0;
+        }
+        // Журнал прогона: PageUp / PageDown - на интервал опорных кадров назад / вперёд
+        const bool seekBack = IsKeyPressed(KEY_PAGE_UP), seekForward = IsKeyPressed(KEY_PAGE_DOWN);
+        if ((seekBack || seekForward) && replayRecorder && cpuBackend) {
+            simThread.Stop();
+            long long target = (long long)worldTick + (seekBack ? -replay.Interval() : replay.Interval());
+            target = std::max(target, (long long)replay.FirstTick());
+            std::string error;
+            if (replay.Seek((unsigned)target, &error)) {
+                simThread.AcquireSnapshot();
+                InvalidateDrawnBlocks(simThread.LatestSnapshot().seq + 1);
+                loadStatus = TextFormat("replay: tick %u of %u", worldTick, replay.EndTick());
+            } else {
+                loadStatus = "seek failed: " + error;
+            }
+            simThread.Start(simThread.TickRate(), simThread.TicksPerFrame());
+            saveStatusUntil = GetTime() + 5.0;
+        }
+
         // Android Touch Zoom (Multitouch simulation logic usually needed, 
         // but basics: drag pan works out of box with mouse simulation)
 
+#if defined(ALIFE_GPU)
+        // Бэкенд рисует в текстуру уровня 0: мир крупнее лимита текстур остаётся на CPU
+        if (IsKeyPressed(KEY_G) && minRenderLevel == 0) {
+            if (!gpuSim.Active()) {
+                simThread.Stop();
+                if (!gpuSim.Start()) simThread.Start(simThread.TickRate(), simThread.TicksPerFrame());
+            } else {
+                gpuSim.Finish();
+                simThread.AcquireSnapshot(); // Забрать снимок, опубликованный до включения GPU
+                InvalidateDrawnBlocks(simThread.LatestSnapshot().seq + 1);
+                simThread.Start(simThread.TickRate(), simThread.TicksPerFrame());
+            }
+        }
+#endif
+
         // --- UPDATE ---
-        UpdateWorld();
+#if defined(ALIFE_GPU)
+        if (gpuSim.Active()) {
+            // Скорость - те же режимы, что у потока симуляции
+            int ticks = 0;
+            if (simThread.Paused()) {
+                ticks = 0;
+            } else if (simThread.TicksPerFrame() > 0) {
+                ticks = simThread.TicksPerFrame();
+            } else if (simThread.TickRate() > 0) {
+                gpuTickCarry = std::min(gpuTickCarry + simThread.TickRate() * GetFrameTime(), simThread.TickRate() * 0.25);
+                ticks = (int)gpuTickCarry;
+                gpuTickCarry -= ticks;
+            } else {
+                ticks = fastForward;
+            }
+            gpuSim.Tick(ticks);
+            gpuSim.Render(GpuBackendTexture());
+            gpuRateTicks += ticks;
+            if (GetTime() - gpuRateStart >= 0.5) {
+                gpuRate = gpuRateTicks / (GetTime() - gpuRateStart);
+                gpuRateStart = GetTime();
+                gpuRateTicks = 0;
+            }
+            hud.tick = worldTick;
+            hud.alive = gpuSim.Alive();
+        } else
+#endif
+        // Тик идёт в потоке симуляции; здесь только забираем свежий снимок, если он есть
+        // Рисуем каждый кадр, а не только по новому снимку: камера могла открыть устаревшие блоки
+        {
+            if (const SimSnapshot* snap = simThread.AcquireSnapshot()) {
+                hud.tick = snap->tick;
+                hud.alive = snap->alive;
+            }
+            DrawWorld(simThread.LatestSnapshot());
+        }
+        simThread.FrameTick();
+        double shownRate = simThread.MeasuredTicksPerSecond();
+#if defined(ALIFE_GPU)
+        if (gpuSim.Active()) shownRate = gpuRate;
+#endif
+        profiler.Record(PROF_FRAME, GetFrameTime() * 1000.0f);
+        if (overlay.visible) overlay.Refresh();
 
         // --- DRAW ---
         BeginDrawing();
             ClearBackground(BLACK);
             
             BeginMode2D(camera);
-                DrawTexture(screenTexture, 0, 0, WHITE);
+#if defined(ALIFE_GPU)
+                if (gpuSim.Active()) DrawTexture(GpuBackendTexture(), 0, 0, WHITE); else
+#endif
+                DrawWorldTexture();
             EndMode2D();
 
             DrawFPS(10, 10);
-            DrawText(TextFormat("Bots: %d", (int)aliveCount), 10, 40, 30, WHITE);
+            DrawText(TextFormat("Bots: %d", hud.alive), 10, 40, 30, WHITE);
+            const char* backend = TextFormat("Threads: %d%s  VM: %s %s  Perf: %s%s%s (F6)", shownThreads,
+                                             shownPinned ? " (big cores)" : "", VmModeName(shownVm),
+                                             shownVm == VM_MODE_SCALAR ? "" : VmSimdKernel(), PerfModeName(perf.mode),
+                                             ThermalStatus() > THERMAL_NONE ? ", thermal " : "",
+                                             ThermalStatus() > THERMAL_NONE ? ThermalName(ThermalStatus()) : "");
+#if defined(ALIFE_GPU)
+            if (gpuSim.Active()) backend = "GPU compute (G - back to CPU)";
+#endif
+            DrawText(backend, 10, 75, 20, WHITE);
+            if (simThread.Paused()) {
+                DrawText(TextFormat("Tick %u  PAUSED", hud.tick), 10, 100, 20, WHITE);
+            } else if (simThread.TicksPerFrame() > 0) {
+                DrawText(TextFormat("Tick %u  %.0f ticks/s  (x%d per frame)", hud.tick, shownRate, simThread.TicksPerFrame()), 10, 100, 20, WHITE);
+            } else if (simThread.TickRate() > 0) {
+                DrawText(TextFormat("Tick %u  %.0f ticks/s  (target %d)", hud.tick, shownRate, simThread.TickRate()), 10, 100, 20, WHITE);
+            } else {
+                DrawText(TextFormat("Tick %u  %.0f ticks/s  (unlimited)", hud.tick, shownRate), 10, 100, 20, WHITE);
+            }
+            DrawText(TextFormat("View: %s (M)  colors: %s (C)  LOD %d", ViewName(shownView), gpuColorize ? "shader" : "CPU",
+                                std::max(shownLevel, 0)),
+                     10, 125, 20, WHITE);
+            if (overlay.visible) overlay.Draw(10, 155);
+            if (GetTime() < saveStatusUntil) {
+                std::string status = !loadStatus.empty() ? loadStatus : saveWriter.Busy() ? "saving " + saveFile : saveWriter.Status();
+                DrawText(status.c_str(), 10, GetScreenHeight() - 30, 20, GREEN);
+            }
         EndDrawing();
     }
 
-    UnloadTexture(screenTexture);
-    UnloadImage(screenImage);
+    simThread.Stop();
+    saveWriter.Wait();
+    statsRecorder = nullptr;
+    recorder.Close();
+    replayRecorder = nullptr;
+    replay.Close();
+#if defined(ALIFE_GPU)
+    gpuSim.Finish();
+#endif
+    UnloadRenderer();
     CloseWindow();
 
     return 0;
@@ -0,0 +1,52 @@
+#include "power.h"
+
+#include <algorithm>
+#include "sim.h"
+
+PerfMode DefaultPerfMode() {
+#if defined(__ANDROID__)
+    return PERF_BALANCED;
+#else
+    return PERF_MAX;
+#endif
+}
+
+PerfSettings PerfSettingsFor(PerfMode mode, int thermal, const SimConfig& cfg, int hardwareThreads) {
+    if (thermal >= THERMAL_SEVERE) mode = PERF_BATTERY;
+    else if (thermal >= THERMAL_MODERATE) mode = std::min(mode, PERF_BALANCED);
+
+    PerfSettings s;
+    s.mode = mode;
+    const int configured = cfg.threads > 0 ? cfg.threads : hardwareThreads;
+    const int rate = cfg.tickRate > 0 ? cfg.tickRate : 60;
+    switch (mode) {
+    case PERF_BATTERY:
+        s.threads = std::min(2, configured);
+        s.tickRate = std::min(rate, 20);
+        s.fps = 30;
+        s.renderLevelBias = 1;
+        break;
+    case PERF_BALANCED:
+        s.threads = std::max(1, std::min(configured, hardwareThreads / 2));
+        s.tickRate = std::min(rate, 60);
+        break;
+    default:
+        s.threads = configured;
+        s.tickRate = cfg.tickRate;
+        break;
+    }
+    return s;
+}
+
+const char* PerfModeName(PerfMode mode) {
+    switch (mode) {
+    case PERF_BATTERY: return "battery";
+    case PERF_BALANCED: return "balanced";
+    default: return "max";
+    }
+}
+
+const char* ThermalName(int thermal) {
+    static const char* const NAMES[] = { "none", "light", "moderate", "severe", "critical", "emergency", "shutdown" };
+    return thermal >= THERMAL_NONE && thermal <= THERMAL_SHUTDOWN ? NAMES[thermal] : "unknown";
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// --- РЕЖИМЫ ПРОИЗВОДИТЕЛЬНОСТИ ---
+// Режим задаёт число воркеров, частоту тиков, FPS и разрешение отрисовки (уровень LOD).
+// Тепловое состояние устройства ограничивает режим сверху: при нагреве приложение само
+// уходит в более экономный режим и возвращается, когда устройство остынет. Ровный темп
+// с запасом по теплу важнее пика, который через минуту срежет троттлинг.
+enum PerfMode : int {
+    PERF_BATTERY = 0, // Экономия: 2 воркера, 20 тиков/с, 30 FPS, отрисовка вдвое грубее
+    PERF_BALANCED,    // Половина ядер, не больше 60 тиков/с
+    PERF_MAX,         // Как задано в конфиге (все ядра, частота из config.tickRate)
+    PERF_MODE_COUNT
+};
+
+// Шкала AThermalStatus (android/thermal.h); на ПК всегда THERMAL_NONE
+enum ThermalLevel : int {
+    THERMAL_NONE = 0,
+    THERMAL_LIGHT,
+    THERMAL_MODERATE, // Дальше - не выше PERF_BALANCED
+    THERMAL_SEVERE,   // Дальше - PERF_BATTERY
+    THERMAL_CRITICAL,
+    THERMAL_EMERGENCY,
+    THERMAL_SHUTDOWN,
+};
+
+struct SimConfig;
+
+struct PerfSettings {
+    PerfMode mode = PERF_MAX; // Действующий режим - после теплового ограничения
+    int threads = 0;
+    int tickRate = 60;        // 0 = без ограничения
+    int fps = 60;
+    int renderLevelBias = 0;  // На сколько уровней LOD грубее, чем нужно по зуму
+};
+
+// Режим по умолчанию, если config.perf не задан: на Android - сбалансированный
+PerfMode DefaultPerfMode();
+PerfSettings PerfSettingsFor(PerfMode mode, int thermal, const SimConfig& cfg, int hardwareThreads);
+
+const char* PerfModeName(PerfMode mode);
+const char* ThermalName(int thermal);
@@ -0,0 +1,163 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__ANDROID__)
+#include <sys/system_properties.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/utsname.h>
+#endif
+
+Profiler profiler;
+
+const char* const PROF_PHASE_NAMES[PROF_COUNT] = {
+    "tick", "think", "claim", "commit", "gather", "diffuse", "sense", "merge", "halo", "snapshot",
+    "grow_cpu", "vm_cpu",
+    "frame", "draw_pixels", "upload_texture",
+};
+
+void Profiler::Series::Add(double v) {
+    if ((int)window.size() < WINDOW) {
+        window.push_back(v);
+    } else {
+        window[next] = v;
+        next = (next + 1) % WINDOW;
+    }
+    count++;
+    sum += v;
+    max = std::max(max, v);
+}
+
+ProfStats Profiler::Series::Stats() const {
+    ProfStats s;
+    s.count = count;
+    if (count == 0) return s;
+    s.mean = sum / count;
+    s.max = max;
+    std::vector<double> sorted(window);
+    std::sort(sorted.begin(), sorted.end());
+    auto pct = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+    s.p50 = pct(0.50);
+    s.p95 = pct(0.95);
+    s.p99 = pct(0.99);
+    return s;
+}
+
+void Profiler::Record(ProfPhase phase, double ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phases_[phase].Add(ms);
+}
+
+void Profiler::RecordWorkers(const std::vector<double>& busy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Число воркеров поменялось - старая статистика про другой пул
+    if (workers_.size() != busy.size()) workers_.assign(busy.size(), Series());
+    for (size_t i = 0; i < busy.size(); i++) workers_[i].Add(busy[i] * 100.0);
+}
+
+ProfStats Profiler::Phase(ProfPhase phase) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return phases_[phase].Stats();
+}
+
+std::vector<ProfStats> Profiler::Workers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ProfStats> out;
+    for (const Series& s : workers_) out.push_back(s.Stats());
+    return out;
+}
+
+void Profiler::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Series& s : phases_) s = Series();
+    workers_.clear();
+}
+
+// --- ЭКСПОРТ ---
+bool Profiler::WriteCsv(const char* path, const std::string& meta) const {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "# %s\n", meta.c_str());
+    std::fprintf(f, "kind,name,count,mean,p50,p95,p99,max\n");
+    auto row = [&](const char* kind, const std::string& name, const ProfStats& s) {
+        std::fprintf(f, "%s,%s,%lld,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                     kind, name.c_str(), s.count, s.mean, s.p50, s.p95, s.p99, s.max);
+    };
+    for (int p = 0; p < PROF_COUNT; p++) {
+        ProfStats s = Phase((ProfPhase)p);
+        if (s.count > 0) row("phase_ms", PROF_PHASE_NAMES[p], s);
+    }
+    std::vector<ProfStats> workers = Workers();
+    for (size_t i = 0; i < workers.size(); i++) row("worker_busy_pct", std::to_string(i), workers[i]);
+    return std::fclose(f) == 0;
+}
+
+bool Profiler::WriteJson(const char* path, const std::string& meta) const {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    auto stats = [&](const ProfStats& s) {
+        std::fprintf(f, "{\"count\": %lld, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+                     s.count, s.mean, s.p50, s.p95, s.p99, s.max);
+    };
+
+    // meta "ключ=значение ..." превращается в строковые поля объекта
+    std::fprintf(f, "{\n  \"meta\": {");
+    size_t pos = 0;
+    bool first = true;
+    while (pos < meta.size()) {
+        size_t end = meta.find(' ', pos);
+        if (end == std::string::npos) end = meta.size();
+        std::string pair = meta.substr(pos, end - pos);
+        size_t eq = pair.find('=');
+        if (eq != std::string::npos) {
+            std::fprintf(f, "%s\"%s\": \"%s\"", first ? "" : ", ", pair.substr(0, eq).c_str(), pair.substr(eq + 1).c_str());
+            first = false;
+        }
+        pos = end + 1;
+    }
+
+    std::fprintf(f, "},\n  \"phases_ms\": {");
+    first = true;
+    for (int p = 0; p < PROF_COUNT; p++) {
+        ProfStats s = Phase((ProfPhase)p);
+        if (s.count == 0) continue;
+        std::fprintf(f, "%s\n    \"%s\": ", first ? "" : ",", PROF_PHASE_NAMES[p]);
+        stats(s);
+        first = false;
+    }
+
+    std::fprintf(f, "\n  },\n  \"worker_busy_pct\": [");
+    std::vector<ProfStats> workers = Workers();
+    for (size_t i = 0; i < workers.size(); i++) {
+        std::fprintf(f, "%s\n    ", i ? "," : "");
+        stats(workers[i]);
+    }
+    std::fprintf(f, "\n  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+bool Profiler::Write(const char* path, const std::string& meta) const {
+    std::string p = path;
+    bool json = p.size() >= 5 && p.compare(p.size() - 5, 5, ".json") == 0;
+    return json ? WriteJson(path, meta) : WriteCsv(path, meta);
+}
+
+std::string DeviceDescription() {
+#if defined(__ANDROID__)
+    char model[PROP_VALUE_MAX] = {0};
+    char soc[PROP_VALUE_MAX] = {0};
+    __system_property_get("ro.product.model", model);
+    __system_property_get("ro.soc.model", soc);
+    std::string out = model;
+    if (soc[0]) out += std::string("/") + soc;
+    for (char& c : out) if (c == ' ') c = '_';
+    return out;
+#elif defined(__unix__) || defined(__APPLE__)
+    utsname info;
+    if (uname(&info) != 0) return "unknown";
+    return std::string(info.sysname) + "/" + info.machine;
+#else
+    return "unknown";
+#endif
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// --- ПРОФИЛИРОВАНИЕ ---
+// Лёгкие таймеры фаз тика и кадра + загрузка воркеров пула.
+// Пишут оба потока (симуляция и рендер), поэтому запись под мьютексом: это десяток
+// коротких захватов на тик/кадр. Перцентили считаются по скользящему окну последних сэмплов.
+enum ProfPhase : int {
+    // Поток симуляции: время по часам (wall)
+    PROF_TICK = 0,  // Весь UpdateWorld
+    PROF_THINK,     // Фаза 1: рост органики + VM
+    PROF_CLAIM,     // Фаза 1b: заявки по цветам
+    PROF_COMMIT,    // Фаза 2: применение намерений
+    PROF_GATHER,    // Фаза 2b: обмен границей
+    PROF_DIFFUSE,   // Диффузия и распад органики (раз в ORGANIC_DIFFUSION_INTERVAL тиков)
+    PROF_SENSE,     // Пересборка SpatialIndex (битборд занятости + таблица органики)
+    PROF_MERGE,     // Возврат геномов в пул и подсчёт живых
+    PROF_HALO,      // Обмен гало с соседними узлами (distributed.h)
+    PROF_SNAPSHOT,  // BuildSnapshot
+    // Суммарное процессорное время всех воркеров внутри фазы 1
+    PROF_GROW_CPU,  // Рост органики
+    PROF_VM_CPU,    // ProcessBot
+    // Поток рендера
+    PROF_FRAME,     // Кадр целиком (между EndDrawing)
+    PROF_DRAW_PIXELS, // Цикл по пикселям в DrawWorld
+    PROF_UPLOAD,    // UpdateTexture
+    PROF_COUNT
+};
+
+extern const char* const PROF_PHASE_NAMES[PROF_COUNT];
+
+struct ProfStats {
+    long long count = 0; // Сэмплов за всё время
+    double mean = 0, max = 0; // За всё время
+    double p50 = 0, p95 = 0, p99 = 0; // По окну
+};
+
+class Profiler {
+public:
+    static const int WINDOW = 1024; // Сэмплов в скользящем окне
+
+    void Record(ProfPhase phase, double ms);
+    // Доля занятости каждого воркера (0..1) за один тик
+    void RecordWorkers(const std::vector<double>& busy);
+
+    ProfStats Phase(ProfPhase phase) const;
+    std::vector<ProfStats> Workers() const; // В процентах занятости; idle = 100 - busy
+    void Reset();
+
+    // Сводка для сравнения устройств. meta - произвольные пары "ключ=значение" через пробел
+    bool WriteCsv(const char* path, const std::string& meta) const;
+    bool WriteJson(const char* path, const std::string& meta) const;
+    bool Write(const char* path, const std::string& meta) const; // По расширению: .json или CSV
+
+private:
+    struct Series {
+        std::vector<double> window;
+        int next = 0;
+        long long count = 0;
+        double sum = 0, max = 0;
+
+        void Add(double v);
+        ProfStats Stats() const;
+    };
+
+    mutable std::mutex mutex_;
+    Series phases_[PROF_COUNT];
+    std::vector<Series> workers_;
+};
+
+extern Profiler profiler;
+
+// Описание устройства для экспорта (модель на Android, uname на ПК)
+std::string DeviceDescription();
+
+// Замер области видимости: ProfScope scope(PROF_THINK);
+class ProfScope {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit ProfScope(ProfPhase phase) : phase_(phase), start_(Clock::now()) {}
+    ~ProfScope() { profiler.Record(phase_, std::chrono::duration<double, std::milli>(Clock::now() - start_).count()); }
+
+    ProfScope(const ProfScope&) = delete;
+    ProfScope& operator=(const ProfScope&) = delete;
+
+private:
+    ProfPhase phase_;
+    Clock::time_point start_;
+};
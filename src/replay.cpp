@@ -0,0 +1,260 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "save.h"
+#include "sim.h"
+#include "stats.h"
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::vector<ReplayEvent> tickEvents;
+ReplayRecorder* replayRecorder = nullptr;
+
+static bool Fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+static void PutVarint(std::vector<unsigned char>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((unsigned char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((unsigned char)v);
+}
+
+static bool GetVarint(const unsigned char*& p, const unsigned char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+std::string ReplayRecorder::KeyPath(unsigned tick) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/key_%010u.sav", tick);
+    return dir_ + name;
+}
+
+bool ReplayRecorder::Open(const std::string& dir, int interval, int ramKeyframes, std::string* error) {
+    Close();
+#if defined(_WIN32)
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    dir_ = dir;
+    file_ = std::fopen((dir + "/events.log").c_str(), "wb");
+    if (!file_) return Fail(error, "cannot write " + dir + "/events.log");
+    interval_ = std::max(interval, 1);
+    ramKeyframes_ = (size_t)std::max(ramKeyframes, 1);
+    firstTick_ = endTick_ = worldTick;
+    dropped_ = 0;
+    ram_.clear();
+    pendingKeys_.clear();
+    diskKeys_.clear();
+    offsets_.clear();
+
+    ReplayLogHeader header = { world.w, world.h, genomeSize, worldSeed, (uint32_t)interval_, firstTick_ };
+    std::fwrite(REPLAY_MAGIC, 1, sizeof(REPLAY_MAGIC), file_);
+    std::fwrite(&header, sizeof(header), 1, file_);
+    Keyframe();
+    running_ = true;
+    thread_ = std::thread(&ReplayRecorder::Loop, this);
+    return true;
+}
+
+void ReplayRecorder::Close() {
+    if (!file_) return;
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+    ram_.clear();
+}
+
+void ReplayRecorder::Keyframe() {
+    std::shared_ptr<const SaveImage> image(CaptureWorld().release());
+    lastKey_ = worldTick;
+    ram_.push_back(image);
+    if (ram_.size() > ramKeyframes_) ram_.pop_front();
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingKeys_.push_back(image);
+}
+
+// Тики идут подряд, кроме пересчёта после Seek: он повторяет уже записанное
+void ReplayRecorder::Record(unsigned tick, const std::vector<ReplayEvent>& events) {
+    if (tick >= endTick_) {
+        TickBlock& block = scratch_;
+        block.tick = tick;
+        block.events = events;
+        if (!queue_.TryPush(block)) dropped_++;
+        endTick_ = tick + 1;
+    }
+    if (worldTick % (unsigned)interval_ == 0 && worldTick > lastKey_) Keyframe();
+}
+
+void ReplayRecorder::WriteBlock(const TickBlock& block) {
+    std::vector<unsigned char>& out = encoded_;
+    out.clear();
+    uint32_t prev = 0;
+    for (const ReplayEvent& e : block.events) {
+        out.push_back((unsigned char)(e.kind | e.dir << 3));
+        int64_t delta = (int64_t)e.cell - (int64_t)prev;
+        PutVarint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63)); // Сдвиг отрицательного int64_t - UB
+        prev = e.cell;
+        if (e.kind == REPLAY_BIRTH) {
+            const unsigned char* g = (const unsigned char*)&e.genome;
+            out.insert(out.end(), g, g + sizeof(e.genome));
+        }
+    }
+    if (block.tick % (unsigned)interval_ == 0 || block.tick == firstTick_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        offsets_[block.tick] = std::ftell(file_);
+    }
+    const uint32_t head[3] = { block.tick, (uint32_t)block.events.size(), (uint32_t)out.size() };
+    std::fwrite(head, sizeof(head), 1, file_);
+    std::fwrite(out.data(), 1, out.size(), file_);
+}
+
+void ReplayRecorder::WriteKeyframes() {
+    std::vector<std::shared_ptr<const SaveImage>> keys;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        keys.swap(pendingKeys_);
+    }
+    for (const auto& image : keys) {
+        const unsigned tick = image->header.tick;
+        std::string error;
+        if (!WriteImage(*image, KeyPath(tick), SaveCompressionAvailable(), &error)) {
+            std::fprintf(stderr, "replay: %s\n", error.c_str());
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        diskKeys_.push_back(tick);
+    }
+}
+
+// Как у StatsRecorder: пустая очередь - короткий сон, поток симуляции никто не будит
+void ReplayRecorder::Loop() {
+    TickBlock block;
+    for (;;) {
+        bool stopping = !running_;
+        bool any = false;
+        while (queue_.TryPop(block)) {
+            WriteBlock(block);
+            any = true;
+        }
+        WriteKeyframes();
+        if (stopping) break;
+        if (!any) {
+            std::fflush(file_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    std::fflush(file_);
+}
+
+int ReplayRecorder::Keyframes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int)diskKeys_.size();
+}
+
+bool ReplayRecorder::Seek(unsigned tick, std::string* error) {
+    if (!file_) return Fail(error, "replay is not recording");
+    if (tick < firstTick_) return Fail(error, "tick " + std::to_string(tick) + " is before the replay start");
+
+    // Ближайший опорный кадр не позже tick: из памяти, иначе с диска. Текущий мир - тоже опора
+    std::shared_ptr<const SaveImage> image;
+    for (const auto& key : ram_) {
+        if (key->header.tick <= tick && (!image || key->header.tick > image->header.tick)) image = key;
+    }
+    bool onDisk = false;
+    unsigned diskTick = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::upper_bound(diskKeys_.begin(), diskKeys_.end(), tick);
+        if (it != diskKeys_.begin()) {
+            onDisk = true;
+            diskTick = *(it - 1);
+        }
+    }
+    const bool useDisk = onDisk && (!image || diskTick > image->header.tick);
+    const unsigned from = useDisk ? diskTick : image ? image->header.tick : 0;
+    if (!image && !onDisk && worldTick > tick) {
+        return Fail(error, "no keyframe before tick " + std::to_string(tick) + " yet");
+    }
+    if (worldTick > tick || worldTick < from) {
+        if (useDisk) {
+            if (!LoadWorld(KeyPath(diskTick).c_str(), error)) return false;
+        } else {
+            RestoreWorld(*image);
+        }
+    }
+
+    // Ряд статистики уже содержит пересчитываемые тики
+    StatsRecorder* stats = statsRecorder;
+    statsRecorder = nullptr;
+    while (worldTick < tick) UpdateWorld();
+    statsRecorder = stats;
+    return true;
+}
+
+bool ReplayRecorder::Events(unsigned tick, std::vector<ReplayEvent>& out) {
+    out.clear();
+    long long offset = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = offsets_.upper_bound(tick);
+        if (it == offsets_.begin()) return false;
+        offset = (--it)->second;
+    }
+    FILE* f = std::fopen((dir_ + "/events.log").c_str(), "rb");
+    if (!f) return false;
+    bool found = false;
+    std::vector<unsigned char> data;
+    uint32_t head[3];
+    std::fseek(f, (long)offset, SEEK_SET);
+    while (std::fread(head, sizeof(head), 1, f) == 1) {
+        if (head[0] != tick) {
+            if (head[0] > tick) break;
+            std::fseek(f, (long)head[2], SEEK_CUR);
+            continue;
+        }
+        data.resize(head[2]);
+        if (std::fread(data.data(), 1, data.size(), f) != data.size()) break;
+        const unsigned char* p = data.data();
+        const unsigned char* end = p + data.size();
+        uint32_t prev = 0;
+        out.reserve(head[1]);
+        for (uint32_t i = 0; i < head[1] && p < end; i++) {
+            ReplayEvent e = {};
+            e.kind = *p & 7;
+            e.dir = *p++ >> 3;
+            uint64_t z;
+            if (!GetVarint(p, end, z)) break;
+            int64_t delta = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+            e.cell = (uint32_t)((int64_t)prev + delta);
+            prev = e.cell;
+            if (e.kind == REPLAY_BIRTH) {
+                if (end - p < (long)sizeof(e.genome)) break;
+                std::memcpy(&e.genome, p, sizeof(e.genome));
+                p += sizeof(e.genome);
+            }
+            out.push_back(e);
+        }
+        found = out.size() == head[1];
+        break;
+    }
+    std::fclose(f);
+    return found;
+}
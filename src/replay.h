@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.h"
+
+// --- ЖУРНАЛ ПРОГОНА (REPLAY) ---
+// Чтобы листать историю прогона назад и вперёд, рядом с ним пишутся:
+//   - опорные кадры: полная копия мира (SaveImage) каждые interval тиков. Последние ramKeyframes
+//     держатся в памяти, все - на диске в формате сохранения (каталог/key_<тик>.sav);
+//   - журнал событий: по тику блок рождений, смертей, перемещений и атак (каталог/events.log).
+// Переход к тику - ближайший опорный кадр не позже него и пересчёт тиков до нужного: тик
+// детерминирован (счётчиковый ГСЧ, фиксированный порядок споров), так что пересчёт даёт тот
+// же мир. Журнал событий состояние не восстанавливает (в нём нет энергии и органики) - он для
+// разбора истории без пересчёта: кто, где и с каким геномом родился и умер.
+// Копия и события снимаются в потоке симуляции, диск - в потоке записи: тик его не ждёт.
+enum ReplayEventKind : unsigned char {
+    REPLAY_BIRTH = 0, // cell - родитель, потомок - сосед по dir; genome - отпечаток генома потомка
+    REPLAY_DEATH,     // Умер от голода
+    REPLAY_EATEN,     // Съеден (в том же тике - REPLAY_ATTACK съевшего)
+    REPLAY_MOVE,      // cell -> сосед по dir
+    REPLAY_ATTACK,    // cell атаковал соседа по dir и забрал его энергию
+};
+
+struct ReplayEvent {
+    uint32_t cell;        // Клетка бота в начале тика
+    unsigned char kind;   // ReplayEventKind
+    unsigned char dir;    // Направление для BIRTH / MOVE / ATTACK
+    uint64_t genome;      // GenomePool::Fingerprint - один и тот же у одинаковых геномов во всём прогоне
+};
+
+// События последнего тика в порядке тайлов (поток симуляции); собираются, только пока replayRecorder задан
+extern std::vector<ReplayEvent> tickEvents;
+
+// events.log: REPLAY_MAGIC, ReplayLogHeader, затем блоки тиков
+//   uint32 tick, uint32 count, uint32 bytes | события
+// Событие: байт kind | dir << 3, клетка - varint разности с клеткой предыдущего события блока
+// (zigzag), у BIRTH ещё 8 байт отпечатка генома.
+const char REPLAY_MAGIC[8] = { 'A', 'L', 'I', 'F', 'E', 'R', 'P', '1' };
+
+struct ReplayLogHeader {
+    int32_t w, h;
+    int32_t genomeSize;
+    uint32_t seed;
+    uint32_t interval;
+    uint32_t firstTick;
+};
+
+struct SaveImage;
+
+class ReplayRecorder {
+public:
+    ~ReplayRecorder() { Close(); }
+
+    // Начать журнал текущего мира в каталоге dir (создаётся); первый опорный кадр - сам текущий мир
+    bool Open(const std::string& dir, int interval, int ramKeyframes, std::string* error = nullptr);
+    void Close(); // Дописывает очередь и опорные кадры на диск
+    bool IsOpen() const { return file_ != nullptr; }
+
+    // Из UpdateWorld после тика tick (worldTick уже tick + 1): события и, по расписанию, опорный кадр.
+    // Тики, пересчитанные при Seek, уже записаны - они пропускаются
+    void Record(unsigned tick, const std::vector<ReplayEvent>& events);
+
+    // Мир в начале тика tick (worldTick == tick, как после InitWorld / LoadWorld). Вызывать там же,
+    // где LoadWorld: в потоке, владеющем миром, при остановленной симуляции. Дальше tick записанного
+    // можно: недостающие тики считаются и пишутся в журнал как обычно
+    bool Seek(unsigned tick, std::string* error = nullptr);
+
+    // События уже записанного на диск тика
+    bool Events(unsigned tick, std::vector<ReplayEvent>& out);
+
+    unsigned FirstTick() const { return firstTick_; }
+    unsigned EndTick() const { return endTick_; } // Записаны тики [FirstTick, EndTick)
+    int Interval() const { return interval_; }
+    int Keyframes();                            // Опорных кадров на диске
+    long long Dropped() const { return dropped_; } // Блоков событий, не влезших в очередь
+    const std::string& Dir() const { return dir_; }
+
+private:
+    struct TickBlock {
+        unsigned tick = 0;
+        std::vector<ReplayEvent> events;
+    };
+
+    void Loop();
+    void WriteBlock(const TickBlock& block);
+    void WriteKeyframes(); // Поток записи: всё, что накопилось в pendingKeys_
+    void Keyframe();       // Поток симуляции: копия текущего мира
+    std::string KeyPath(unsigned tick) const;
+
+    SpscQueue<TickBlock> queue_{256};
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<long long> dropped_{0};
+    FILE* file_ = nullptr;
+    std::string dir_;
+    int interval_ = 500;
+    size_t ramKeyframes_ = 8;
+    unsigned firstTick_ = 0, endTick_ = 0;
+    unsigned lastKey_ = 0;
+
+    // Поток симуляции: последние опорные кадры в памяти
+    std::deque<std::shared_ptr<const SaveImage>> ram_;
+    TickBlock scratch_; // Блок для очереди: память событий переиспользуется
+
+    // Общее с потоком записи
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<const SaveImage>> pendingKeys_; // Ещё не на диске
+    std::vector<unsigned> diskKeys_;                             // Тики опорных кадров на диске, по возрастанию
+    std::map<unsigned, long long> offsets_;                      // Тик опорного кадра -> смещение его блока в events.log
+    std::vector<unsigned char> encoded_;                         // Буфер кодирования (поток записи)
+};
+
+// Куда UpdateWorld отдаёт события тика (nullptr - журнал выключен). Задаётся до старта потока симуляции.
+extern ReplayRecorder* replayRecorder;
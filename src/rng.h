@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+// --- СЧЁТНЫЙ ГЕНЕРАТОР (counter-based RNG) ---
+// Случайное число - чистая функция от (seed, тик, клетка, поток), а не состояние общего генератора.
+// Поэтому результат не зависит ни от числа потоков, ни от порядка обработки, а в горячем
+// цикле нет разделяемых данных. Hash32 - только сдвиги, xor и умножения: цикл по клеткам
+// векторизуется компилятором (NEON / SSE / AVX2).
+
+// Биективное перемешивание 32 бит ("lowbias32", Chris Wellons)
+inline uint32_t Hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Независимые потоки случайности для разных целей
+enum RngStream : uint32_t {
+    RNG_STREAM_INIT_CELL = 1,   // Органика и спавн при генерации
+    RNG_STREAM_INIT_GENOME = 2, // Геномы при генерации
+    RNG_STREAM_ORGANIC = 3,     // Прирост органики
+    RNG_STREAM_MUTATION = 4,    // Мутации потомков (по клетке родителя)
+};
+
+// Ключ на (seed, тик, поток): дальше значение для клетки = Hash32(key ^ cell)
+inline uint32_t RngKey(uint32_t seed, uint32_t tick, uint32_t stream) {
+    return Hash32(seed ^ Hash32(tick * 0x9E3779B9u ^ Hash32(stream + 0x632BE5ABu)));
+}
+
+inline uint32_t CellRandom(uint32_t key, uint32_t cell) { return Hash32(key ^ cell); }
+
+// Последовательность чисел для одной клетки (например, байты генома): счётчик внутри ключа
+struct CounterRng {
+    uint32_t key;
+    uint32_t counter;
+
+    CounterRng(uint32_t streamKey, uint32_t cell) : key(Hash32(streamKey ^ cell)), counter(0) {}
+
+    uint32_t Next() { return Hash32(key + 0x9E3779B9u * ++counter); }
+};
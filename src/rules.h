@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+// --- ПРАВИЛА МИРА ---
+// Числа, на которых держится экономика бота, и топология мира. Правила задаются в config
+// (config.rules) и фиксируются в AllocateWorld: на весь мир, до следующего AllocateWorld.
+//
+// Ход бота (vm.cpp) и применение намерений (CommitBot, sim.cpp) - шаблоны по типу правил:
+// код читает rules.photosynthesis и т.п. и не знает, откуда число. У пресета поля -
+// static constexpr, и код собирается с константами (свёртка, без загрузок); у RuntimeRules -
+// обычные поля, код один на любые числа. Топология - всегда параметр шаблона: проверки края
+// есть только в коде ограниченного мира.
+// WithRules при смене правил выбирает тип пресета, если числа совпали с ним, иначе - общий.
+struct SimRules {
+    int commandLimit = 10;      // Команд за ход (компиляция генома, vm.h)
+    int photosynthesis = 5;     // Энергии за фотосинтез
+    int eatCap = 20;            // Органики за одно поедание, не больше
+    int moveCost = 2;           // Энергии за шаг
+    int existenceCost = 1;      // Энергии за ход
+    int corpseOrganic = 50;     // Органики от трупа
+    int divideMinEnergy = 100;  // Делится бот с энергией не меньше этой
+    int divideCost = 10;        // Цена деления (остаток - пополам с потомком)
+    uint32_t mutationThreshold = 1u << 30; // Потомок мутирует с вероятностью threshold / 2^32 (1/4)
+    bool bounded = false;       // true - у мира края (стены), false - тор
+
+    bool SameNumbers(const SimRules& o) const {
+        return commandLimit == o.commandLimit && photosynthesis == o.photosynthesis && eatCap == o.eatCap &&
+               moveCost == o.moveCost && existenceCost == o.existenceCost && corpseOrganic == o.corpseOrganic &&
+               divideMinEnergy == o.divideMinEnergy && divideCost == o.divideCost &&
+               mutationThreshold == o.mutationThreshold;
+    }
+};
+
+// Пресет: все числа - параметры шаблона
+template <int CommandLimit, int Photosynthesis, int EatCap, int MoveCost, int ExistenceCost, int CorpseOrganic,
+          int DivideMinEnergy, int DivideCost, uint32_t MutationThreshold, bool Bounded>
+struct PresetRules {
+    static constexpr int commandLimit = CommandLimit;
+    static constexpr int photosynthesis = Photosynthesis;
+    static constexpr int eatCap = EatCap;
+    static constexpr int moveCost = MoveCost;
+    static constexpr int existenceCost = ExistenceCost;
+    static constexpr int corpseOrganic = CorpseOrganic;
+    static constexpr int divideMinEnergy = DivideMinEnergy;
+    static constexpr int divideCost = DivideCost;
+    static constexpr uint32_t mutationThreshold = MutationThreshold;
+    static constexpr bool bounded = Bounded;
+
+    PresetRules() = default;
+    explicit PresetRules(const SimRules&) {} // Числа в типе: WithRules уже сверил их с SimRules
+
+    static SimRules Value() {
+        SimRules r;
+        r.commandLimit = commandLimit;
+        r.photosynthesis = photosynthesis;
+        r.eatCap = eatCap;
+        r.moveCost = moveCost;
+        r.existenceCost = existenceCost;
+        r.corpseOrganic = corpseOrganic;
+        r.divideMinEnergy = divideMinEnergy;
+        r.divideCost = divideCost;
+        r.mutationThreshold = mutationThreshold;
+        r.bounded = bounded;
+        return r;
+    }
+};
+
+// Исходные правила симуляции
+template <bool Bounded>
+using ClassicRules = PresetRules<10, 5, 20, 2, 1, 50, 100, 10, 1u << 30, Bounded>;
+// Голодный мир: солнце и падаль вдвое беднее, деление дороже - отбор на хищников и экономных
+template <bool Bounded>
+using ScarceRules = PresetRules<10, 3, 10, 2, 1, 25, 150, 20, 1u << 30, Bounded>;
+
+// Любые числа во время выполнения; топология по-прежнему константа
+template <bool Bounded>
+struct RuntimeRules {
+    int commandLimit, photosynthesis, eatCap, moveCost, existenceCost, corpseOrganic, divideMinEnergy, divideCost;
+    uint32_t mutationThreshold;
+    static constexpr bool bounded = Bounded;
+
+    explicit RuntimeRules(const SimRules& r)
+        : commandLimit(r.commandLimit), photosynthesis(r.photosynthesis), eatCap(r.eatCap), moveCost(r.moveCost),
+          existenceCost(r.existenceCost), corpseOrganic(r.corpseOrganic), divideMinEnergy(r.divideMinEnergy),
+          divideCost(r.divideCost), mutationThreshold(r.mutationThreshold) {}
+};
+
+// Пресеты по имени: ключ config "rules" (числа пресета, отдельные ключи их дальше правят)
+const char* const RULES_PRESET_NAMES[] = { "classic", "scarce" };
+const int RULES_PRESET_COUNT = 2;
+
+inline SimRules RulesPreset(int preset, bool bounded) {
+    SimRules r = preset == 1 ? ScarceRules<false>::Value() : ClassicRules<false>::Value();
+    r.bounded = bounded;
+    return r;
+}
+
+// Вызывает fn(R(rules)) с типом правил для rules: пресет, если числа совпали (и specialized), иначе
+// RuntimeRules. Каждый вызов fn - отдельная специализация; возвращает имя ядра ("classic", "scarce-bounded",
+// "generic"...). fn получает правила по значению: у пресета это пустой объект
+template <class Fn>
+const char* WithRules(const SimRules& rules, bool specialized, Fn&& fn) {
+    if (specialized && rules.SameNumbers(ClassicRules<false>::Value())) {
+        if (rules.bounded) fn(ClassicRules<true>(rules));
+        else fn(ClassicRules<false>(rules));
+        return rules.bounded ? "classic-bounded" : "classic";
+    }
+    if (specialized && rules.SameNumbers(ScarceRules<false>::Value())) {
+        if (rules.bounded) fn(ScarceRules<true>(rules));
+        else fn(ScarceRules<false>(rules));
+        return rules.bounded ? "scarce-bounded" : "scarce";
+    }
+    if (rules.bounded) fn(RuntimeRules<true>(rules));
+    else fn(RuntimeRules<false>(rules));
+    return rules.bounded ? "generic-bounded" : "generic";
+}
+
+// Действующие правила мира (задаёт SetVmRules)
+extern SimRules simRules;
@@ -0,0 +1,406 @@
+#include "save.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "sim.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(ALIFE_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+bool SaveCompressionAvailable() {
+#if defined(ALIFE_HAVE_ZSTD)
+    return true;
+#else
+    return false;
+#endif
+}
+
+static bool Fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+// --- КОПИЯ МИРА ---
+std::unique_ptr<SaveImage> CaptureWorld() {
+    std::unique_ptr<SaveImage> image(new SaveImage());
+    const WorldBuffer& grid = worldGrid;
+    const size_t cells = (size_t)world.cells;
+    SaveHeader& hdr = image->header;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, SAVE_MAGIC, sizeof(hdr.magic));
+    hdr.version = SAVE_VERSION;
+    hdr.endianTag = SAVE_ENDIAN_TAG;
+    hdr.headerBytes = sizeof(SaveHeader);
+    hdr.w = world.w;
+    hdr.h = world.h;
+    hdr.genomeSize = genomeSize;
+    hdr.tick = worldTick;
+    hdr.seed = worldSeed;
+
+    image->alive.assign(grid.alive.begin(), grid.alive.begin() + cells);
+    image->ip.assign(grid.ip.begin(), grid.ip.begin() + cells);
+    image->dir.assign(grid.dir.begin(), grid.dir.begin() + cells);
+    image->color.assign(grid.color.begin(), grid.color.begin() + cells);
+    image->energy = grid.energy;
+    image->organic = grid.organic;
+    image->genome = grid.genome;
+    image->born = grid.born;
+    image->pool = genomePool.data;
+    return image;
+}
+
+// --- ЗАПИСЬ ---
+struct SectionSource {
+    uint32_t id;
+    const void* data;
+    size_t bytes;
+};
+
+// Слоты пула -> индексы таблицы геномов (в cellIndex, копия не меняется: её может держать и
+// журнал прогона). Слоты пула уже уникальны (GenomePool::Intern), так что таблица - это живые
+// слоты без дыр свободных
+static std::vector<unsigned char> DedupGenomes(const SaveImage& image, std::vector<int>& cellIndex) {
+    const size_t size = (size_t)image.header.genomeSize;
+    std::vector<unsigned char> table;
+    std::vector<int> slotIndex(image.pool.size() / size, -1);
+    cellIndex.assign(image.genome.size(), -1);
+    for (size_t i = 0; i < image.genome.size(); i++) {
+        if (!image.alive[i]) continue;
+        int& index = slotIndex[image.genome[i]];
+        if (index < 0) {
+            index = (int)(table.size() / size);
+            const unsigned char* genome = &image.pool[(size_t)image.genome[i] * size];
+            table.insert(table.end(), genome, genome + size);
+        }
+        cellIndex[i] = index;
+    }
+    return table;
+}
+
+bool WriteImage(const SaveImage& image, const std::string& path, bool compress, std::string* error) {
+    std::vector<int> genomeIndex;
+    std::vector<unsigned char> genomes = DedupGenomes(image, genomeIndex);
+    SaveHeader header = image.header;
+    header.genomeCount = (uint32_t)(genomes.size() / (size_t)header.genomeSize);
+    const size_t cells = image.alive.size();
+    const SectionSource sources[] = {
+        { SAVE_ALIVE, image.alive.data(), cells },
+        { SAVE_ENERGY, image.energy.data(), cells * sizeof(int) },
+        { SAVE_ORGANIC, image.organic.data(), cells * sizeof(int) },
+        { SAVE_IP, image.ip.data(), cells },
+        { SAVE_DIR, image.dir.data(), cells },
+        { SAVE_COLOR, image.color.data(), cells },
+        { SAVE_BORN, image.born.data(), cells * sizeof(unsigned) },
+        { SAVE_GENOME_INDEX, genomeIndex.data(), cells * sizeof(int) },
+        { SAVE_GENOMES, genomes.data(), genomes.size() },
+    };
+    const int count = (int)(sizeof(sources) / sizeof(sources[0]));
+
+    // Секции сжимаются заранее: смещения зависят от итоговых размеров
+    std::vector<std::vector<unsigned char>> packed(count);
+    std::vector<SaveSection> table(count);
+    uint64_t offset = sizeof(SaveHeader) + sizeof(SaveSection) * count;
+    for (int s = 0; s < count; s++) {
+        SaveSection& sec = table[s];
+        sec.id = sources[s].id;
+        sec.codec = SAVE_CODEC_NONE;
+        sec.rawBytes = sources[s].bytes;
+        sec.bytes = sources[s].bytes;
+#if defined(ALIFE_HAVE_ZSTD)
+        if (compress && sources[s].bytes > 0) {
+            std::vector<unsigned char>& out = packed[s];
+            out.resize(ZSTD_compressBound(sources[s].bytes));
+            size_t n = ZSTD_compress(out.data(), out.size(), sources[s].data, sources[s].bytes, 3);
+            if (!ZSTD_isError(n) && n < sources[s].bytes) {
+                out.resize(n);
+                sec.codec = SAVE_CODEC_ZSTD;
+                sec.bytes = n;
+            } else {
+                out.clear();
+            }
+        }
+#else
+        (void)compress;
+#endif
+        offset = (offset + SAVE_ALIGN - 1) / SAVE_ALIGN * SAVE_ALIGN;
+        sec.offset = offset;
+        offset += sec.bytes;
+    }
+    header.sectionCount = (uint32_t)count;
+
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return Fail(error, "cannot write " + tmp);
+    bool ok = std::fwrite(&header, sizeof(SaveHeader), 1, f) == 1 &&
+              std::fwrite(table.data(), sizeof(SaveSection), count, f) == (size_t)count;
+    uint64_t written = sizeof(SaveHeader) + sizeof(SaveSection) * count;
+    static const unsigned char zeros[SAVE_ALIGN] = {};
+    for (int s = 0; s < count && ok; s++) {
+        ok = std::fwrite(zeros, 1, table[s].offset - written, f) == table[s].offset - written;
+        const void* data = table[s].codec == SAVE_CODEC_NONE ? sources[s].data : packed[s].data();
+        ok = ok && (table[s].bytes == 0 || std::fwrite(data, 1, table[s].bytes, f) == table[s].bytes);
+        written = table[s].offset + table[s].bytes;
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+        std::remove(tmp.c_str());
+        return Fail(error, "write failed: " + tmp);
+    }
+#if defined(_WIN32)
+    std::remove(path.c_str()); // rename в Windows не заменяет существующий файл
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return Fail(error, "cannot rename " + tmp + " to " + path);
+    }
+    return true;
+}
+
+bool SaveWorld(const char* path, bool compress, std::string* error) {
+    std::unique_ptr<SaveImage> image = CaptureWorld();
+    return WriteImage(*image, path, compress, error);
+}
+
+bool SaveWriter::SaveAsync(const std::string& path, bool compress) {
+    if (busy_) return false;
+    if (thread_.joinable()) thread_.join();
+    std::shared_ptr<SaveImage> image(CaptureWorld().release());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.clear();
+    }
+    busy_ = true;
+    thread_ = std::thread([this, image, path, compress] {
+        std::string error;
+        bool ok = WriteImage(*image, path, compress, &error);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            status_ = ok ? "saved " + path : error;
+        }
+        busy_ = false;
+    });
+    return true;
+}
+
+void SaveWriter::Wait() {
+    if (thread_.joinable()) thread_.join();
+}
+
+std::string SaveWriter::Status() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+// --- ЗАГРУЗКА ---
+// Замена мира проверенными массивами: genomeIndex - индекс в таблице genomes у живых клеток
+static void ApplyWorld(const SaveHeader& hdr, const unsigned char* alive, const void* energy, const void* organic,
+                       const unsigned char* ip, const unsigned char* dir, const unsigned char* color, const void* born,
+                       const unsigned char* genomeIndex, const unsigned char* genomes, size_t genomeCount) {
+    const size_t cells = (size_t)hdr.w * hdr.h;
+    config.worldW = hdr.w;
+    config.worldH = hdr.h;
+    config.genomeSize = hdr.genomeSize;
+    config.seed = hdr.seed;
+    AllocateWorld();
+    worldTick = hdr.tick;
+
+    WorldBuffer& grid = worldGrid;
+    std::memcpy(grid.alive.data(), alive, cells);
+    std::memcpy(grid.energy.data(), energy, cells * sizeof(int));
+    std::memcpy(grid.organic.data(), organic, cells * sizeof(int));
+    std::memcpy(grid.ip.data(), ip, cells);
+    std::memcpy(grid.dir.data(), dir, cells);
+    std::memcpy(grid.color.data(), color, cells);
+    std::memcpy(grid.born.data(), born, cells * sizeof(unsigned));
+
+    // Каждый геном таблицы интернируется (и компилируется) один раз; ссылки пересчитает RebuildBotLists
+    std::vector<int> slots(genomeCount, -1);
+    for (size_t i = 0; i < cells; i++) {
+        if (!alive[i]) continue;
+        int32_t g;
+        std::memcpy(&g, genomeIndex + i * sizeof(int32_t), sizeof(g));
+        if (slots[g] < 0) slots[g] = genomePool.Intern(genomes + (size_t)g * genomeSize);
+        grid.genome[i] = slots[g];
+    }
+    RebuildBotLists();
+}
+
+// Копия в памяти хранит слоты пула как есть: таблица геномов - весь пул копии
+void RestoreWorld(const SaveImage& image) {
+    ApplyWorld(image.header, image.alive.data(), image.energy.data(), image.organic.data(), image.ip.data(),
+               image.dir.data(), image.color.data(), image.born.data(), (const unsigned char*)image.genome.data(),
+               image.pool.data(), image.pool.size() / (size_t)image.header.genomeSize);
+}
+
+// Файл целиком в памяти: mmap там, где он есть (несжатые секции читаются прямо из страниц),
+// иначе обычное чтение
+class MappedFile {
+public:
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (data_) munmap((void*)data_, size_);
+#endif
+    }
+
+    bool Open(const char* path) {
+#if !defined(_WIN32)
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+        if (ok) {
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok) {
+                data_ = (const unsigned char*)p;
+                size_ = (size_t)st.st_size;
+            }
+        }
+        close(fd);
+        return ok;
+#else
+        FILE* f = std::fopen(path, "rb");
+        if (!f) return false;
+        std::fseek(f, 0, SEEK_END);
+        long size = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        bool ok = size > 0;
+        if (ok) {
+            buffer_.resize((size_t)size);
+            ok = std::fread(buffer_.data(), 1, buffer_.size(), f) == buffer_.size();
+        }
+        std::fclose(f);
+        size_ = buffer_.size();
+        return ok;
+#endif
+    }
+
+    const unsigned char* Data() const {
+#if !defined(_WIN32)
+        return data_;
+#else
+        return buffer_.data();
+#endif
+    }
+    size_t Size() const { return size_; }
+
+private:
+#if !defined(_WIN32)
+    const unsigned char* data_ = nullptr;
+#else
+    std::vector<unsigned char> buffer_;
+#endif
+    size_t size_ = 0;
+};
+
+// Несжатая секция - указатель в отображение, сжатая распаковывается в storage
+static const unsigned char* SectionData(const MappedFile& file, const SaveSection& sec,
+                                        std::vector<unsigned char>& storage, std::string* error) {
+    if (sec.codec == SAVE_CODEC_NONE) {
+        if (sec.bytes != sec.rawBytes) {
+            Fail(error, "corrupt save section");
+            return nullptr;
+        }
+        return file.Data() + sec.offset;
+    }
+#if defined(ALIFE_HAVE_ZSTD)
+    if (sec.codec == SAVE_CODEC_ZSTD) {
+        storage.resize((size_t)sec.rawBytes);
+        size_t n = ZSTD_decompress(storage.data(), storage.size(), file.Data() + sec.offset, (size_t)sec.bytes);
+        if (ZSTD_isError(n) || n != sec.rawBytes) {
+            Fail(error, "corrupt zstd section");
+            return nullptr;
+        }
+        return storage.data();
+    }
+#else
+    (void)storage;
+    if (sec.codec == SAVE_CODEC_ZSTD) {
+        Fail(error, "save is zstd-compressed, rebuild with ALIFE_ZSTD");
+        return nullptr;
+    }
+#endif
+    Fail(error, "unknown section codec");
+    return nullptr;
+}
+
+bool LoadWorld(const char* path, std::string* error) {
+    MappedFile file;
+    if (!file.Open(path)) return Fail(error, std::string("cannot open ") + path);
+    if (file.Size() < sizeof(SaveHeader)) return Fail(error, "not a save file");
+
+    SaveHeader hdr;
+    std::memcpy(&hdr, file.Data(), sizeof(hdr));
+    if (std::memcmp(hdr.magic, SAVE_MAGIC, sizeof(hdr.magic)) != 0) return Fail(error, "not a save file");
+    if (hdr.version != SAVE_VERSION) return Fail(error, "unsupported save version " + std::to_string(hdr.version));
+    if (hdr.endianTag != SAVE_ENDIAN_TAG) return Fail(error, "save has different byte order");
+    if (hdr.headerBytes != sizeof(SaveHeader) ||
+        hdr.sectionCount > 64 || file.Size() < sizeof(SaveHeader) + sizeof(SaveSection) * (size_t)hdr.sectionCount) {
+        return Fail(error, "corrupt save header");
+    }
+    if (hdr.w < MIN_WORLD_SIDE || hdr.h < MIN_WORLD_SIDE || (long long)hdr.w * hdr.h > MAX_WORLD_CELLS ||
+        hdr.genomeSize < MIN_GENOME_SIZE || hdr.genomeSize > MAX_GENOME_SIZE) {
+        return Fail(error, "save has invalid world parameters");
+    }
+    const size_t cells = (size_t)hdr.w * hdr.h;
+
+    // Ожидаемый размер каждой секции после распаковки
+    struct Wanted { uint32_t id; size_t rawBytes; const unsigned char* data; };
+    Wanted wanted[] = {
+        { SAVE_ALIVE, cells, nullptr },
+        { SAVE_ENERGY, cells * sizeof(int), nullptr },
+        { SAVE_ORGANIC, cells * sizeof(int), nullptr },
+        { SAVE_IP, cells, nullptr },
+        { SAVE_DIR, cells, nullptr },
+        { SAVE_COLOR, cells, nullptr },
+        { SAVE_BORN, cells * sizeof(unsigned), nullptr },
+        { SAVE_GENOME_INDEX, cells * sizeof(int), nullptr },
+        { SAVE_GENOMES, (size_t)hdr.genomeCount * hdr.genomeSize, nullptr },
+    };
+    std::vector<std::vector<unsigned char>> storage(sizeof(wanted) / sizeof(wanted[0]));
+    const SaveSection* sections = (const SaveSection*)(file.Data() + sizeof(SaveHeader));
+    for (uint32_t s = 0; s < hdr.sectionCount; s++) {
+        SaveSection sec;
+        std::memcpy(&sec, &sections[s], sizeof(sec));
+        if (sec.offset > file.Size() || sec.bytes > file.Size() - sec.offset) return Fail(error, "truncated save file");
+        for (size_t k = 0; k < storage.size(); k++) {
+            if (wanted[k].id != sec.id) continue; // Незнакомые секции пропускаются
+            if (sec.rawBytes != wanted[k].rawBytes) return Fail(error, "section size does not match the world");
+            wanted[k].data = SectionData(file, sec, storage[k], error);
+            if (!wanted[k].data) return false;
+        }
+    }
+    for (const Wanted& w : wanted) {
+        if (!w.data && w.rawBytes > 0) return Fail(error, "save is missing section " + std::to_string(w.id));
+    }
+    const unsigned char* alive = wanted[0].data;
+    const unsigned char* ip = wanted[3].data;
+    const unsigned char* dir = wanted[4].data;
+    const unsigned char* color = wanted[5].data;
+    const unsigned char* genomeIndex = wanted[7].data;
+    const unsigned char* genomes = wanted[8].data;
+    // ip индексирует код генома, color - палитры отрисовки: чужое значение читало бы за их концом
+    for (size_t i = 0; i < cells; i++) {
+        if (alive[i] > 1 || ip[i] >= hdr.genomeSize || color[i] > BOT_COLOR_RED || dir[i] >= 8) {
+            return Fail(error, "save has invalid cell state");
+        }
+        int32_t g;
+        std::memcpy(&g, genomeIndex + i * sizeof(int32_t), sizeof(g));
+        if (alive[i] && (g < 0 || (uint32_t)g >= hdr.genomeCount)) return Fail(error, "bot with invalid genome index");
+    }
+
+    // Файл проверен - дальше мир заменяется
+    ApplyWorld(hdr, alive, wanted[1].data, wanted[2].data, ip, dir, color,
+               wanted[6].data, genomeIndex, genomes, hdr.genomeCount);
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- СОХРАНЕНИЕ МИРА ---
+// Бинарный файл, который можно отобразить в память и раскладывать без разбора:
+//   SaveHeader | SaveSection[sectionCount] | секции (каждая выровнена на SAVE_ALIGN)
+// Секции - плотные SoA-массивы сетки как есть (в порядке клеток), индекс генома на клетку
+// и таблица уникальных геномов (genomeCount * genomeSize байт, как слоты GenomePool).
+// Состояние ГСЧ - seed и тик: случайность счётчиковая (rng.h), поэтому продолжение после
+// загрузки побитово совпадает с непрерывным прогоном. Числа - little-endian, как в памяти на x86 и ARM.
+// Секция может быть сжата zstd (сборка с ALIFE_ZSTD), если это даёт выигрыш.
+
+const char SAVE_MAGIC[8] = { 'A', 'L', 'I', 'F', 'E', 'S', 'A', 'V' };
+const uint32_t SAVE_VERSION = 1;
+const uint32_t SAVE_ENDIAN_TAG = 0x01020304;
+const int SAVE_ALIGN = 64;
+
+enum SaveSectionId : uint32_t {
+    SAVE_ALIVE = 1,        // uint8 на клетку
+    SAVE_ENERGY,           // int32
+    SAVE_ORGANIC,          // int32
+    SAVE_IP,               // uint8
+    SAVE_DIR,              // uint8
+    SAVE_COLOR,            // uint8
+    SAVE_BORN,             // uint32
+    SAVE_GENOME_INDEX,     // int32: индекс в таблице геномов, -1 у пустых клеток
+    SAVE_GENOMES,          // genomeCount * genomeSize байт
+};
+
+enum SaveCodec : uint32_t {
+    SAVE_CODEC_NONE = 0,
+    SAVE_CODEC_ZSTD = 1,
+};
+
+struct SaveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t headerBytes;  // sizeof(SaveHeader) - таблица секций лежит сразу за ним
+    uint32_t sectionCount;
+    int32_t w, h;
+    int32_t genomeSize;
+    uint32_t genomeCount;  // Уникальных геномов в таблице
+    uint32_t tick;
+    uint32_t seed;
+    uint32_t reserved[4];
+};
+
+struct SaveSection {
+    uint32_t id;       // SaveSectionId
+    uint32_t codec;    // SaveCodec
+    uint64_t offset;   // От начала файла
+    uint64_t bytes;    // В файле
+    uint64_t rawBytes; // После распаковки
+};
+
+static_assert(sizeof(SaveHeader) == 64, "SaveHeader layout");
+static_assert(sizeof(SaveSection) == 32, "SaveSection layout");
+
+// --- КОПИЯ МИРА ---
+// Всё, что нужно писателю, без ссылок на живой мир: снимается за несколько memcpy.
+// genome - слоты пула копии (pool - genomePool.data), в файл уходят индексы таблицы уникальных.
+// Записью копия не меняется, так что одну копию могут держать несколько читателей (журнал, replay.h).
+struct SaveImage {
+    SaveHeader header;
+    std::vector<unsigned char> alive, ip, dir, color;
+    std::vector<int> energy, organic, genome;
+    std::vector<unsigned> born;
+    std::vector<unsigned char> pool;
+};
+
+// Вызывать в потоке, который владеет миром
+std::unique_ptr<SaveImage> CaptureWorld();
+// Из любого потока
+bool WriteImage(const SaveImage& image, const std::string& path, bool compress, std::string* error = nullptr);
+// Заменяет мир копией - как LoadWorld, но без файла
+void RestoreWorld(const SaveImage& image);
+
+// Собрана ли поддержка сжатия
+bool SaveCompressionAvailable();
+
+// Синхронно: снять копию мира и записать. Вызывать в потоке, который владеет миром.
+bool SaveWorld(const char* path, bool compress, std::string* error = nullptr);
+
+// Заменяет мир содержимым файла (config.worldW/H, genomeSize и seed берутся из файла).
+// Вызывать там же, где InitWorld: при остановленном потоке симуляции.
+bool LoadWorld(const char* path, std::string* error = nullptr);
+
+// Фоновая запись: в потоке симуляции (через SimThread::Post) снимается только копия
+// массивов мира, дедупликация геномов, сжатие и запись идут в своём потоке.
+// Файл пишется во временный path.tmp и переименовывается, так что старое сохранение
+// не портится, если запись прервалась. SaveAsync вызывается из потока, владеющего миром;
+// Wait (и деструктор) - когда этот поток уже не сохраняет (например, остановлен).
+class SaveWriter {
+public:
+    ~SaveWriter() { Wait(); }
+
+    // false - предыдущая запись ещё идёт (новая не начата)
+    bool SaveAsync(const std::string& path, bool compress);
+    bool Busy() const { return busy_; }
+    void Wait();
+
+    // Итог последней законченной записи ("saved ..." / ошибка), пусто пока пишется
+    std::string Status();
+
+private:
+    std::thread thread_;
+    std::atomic<bool> busy_{false};
+    std::mutex mutex_;
+    std::string status_;
+};
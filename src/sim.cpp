@@ -0,0 +1,1201 @@
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include "power.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rng.h"
+#include "spatial.h"
+#include "stats.h"
+
+SimConfig config;
+
+// Один параметр: "width", "height", "genome", "threads", "seed", "rate", "ticks_per_frame", "pin",
+// "vm" (scalar / simd / check или 0 / 1 / 2), "stats" (путь к файлу), "replay" (каталог журнала),
+// "replay_interval", "replay_keyframes"; правила (rules.h): "rules" (имя пресета), "command_limit", "photosynthesis",
+// "eat_cap", "move_cost", "existence_cost", "corpse_organic", "divide_min_energy", "divide_cost",
+// "mutation_threshold" (из 2^32), "bounded" (0 / 1), "generic_rules" (0 / 1)
+bool ApplyConfigValue(SimConfig& cfg, const std::string& key, const std::string& value) {
+    if (key == "vm") {
+        for (int mode = VM_MODE_SCALAR; mode <= VM_MODE_CHECK; mode++) {
+            if (value == VmModeName((VmMode)mode)) {
+                cfg.vm = mode;
+                return true;
+            }
+        }
+    }
+    if (key == "perf") {
+        for (int mode = PERF_BATTERY; mode < PERF_MODE_COUNT; mode++) {
+            if (value == PerfModeName((PerfMode)mode)) {
+                cfg.perf = mode;
+                return true;
+            }
+        }
+    }
+    if (key == "stats") {
+        cfg.stats = value;
+        return true;
+    }
+    if (key == "replay") {
+        cfg.replay = value;
+        return true;
+    }
+    if (key == "rules") {
+        for (int preset = 0; preset < RULES_PRESET_COUNT; preset++) {
+            if (value == RULES_PRESET_NAMES[preset]) {
+                cfg.rules = RulesPreset(preset, cfg.rules.bounded);
+                return true;
+            }
+        }
+        std::fprintf(stderr, "config: unknown rules preset '%s'\n", value.c_str());
+        return false;
+    }
+    char* end = nullptr;
+    long long v = std::strtoll(value.c_str(), &end, 10);
+    bool isNumber = !value.empty() && end && *end == 0;
+    if (key == "pin") {
+        cfg.pinBigCores = value.empty() || value == "1" || value == "true" || value == "yes";
+        return true;
+    }
+    if (!isNumber) {
+        std::fprintf(stderr, "config: '%s' expects a number, got '%s'\n", key.c_str(), value.c_str());
+        return false;
+    }
+    if (key == "width") cfg.worldW = (int)v;
+    else if (key == "height") cfg.worldH = (int)v;
+    else if (key == "genome") cfg.genomeSize = (int)v;
+    else if (key == "threads") cfg.threads = (int)v;
+    else if (key == "seed") cfg.seed = (unsigned)v;
+    else if (key == "rate") cfg.tickRate = (int)v;
+    else if (key == "ticks_per_frame") cfg.ticksPerFrame = (int)v;
+    else if (key == "vm") cfg.vm = (int)v;
+    else if (key == "perf") cfg.perf = (int)v;
+    else if (key == "replay_interval") cfg.replayInterval = (int)v;
+    else if (key == "replay_keyframes") cfg.replayKeyframes = (int)v;
+    else if (key == "command_limit") cfg.rules.commandLimit = (int)v;
+    else if (key == "photosynthesis") cfg.rules.photosynthesis = (int)v;
+    else if (key == "eat_cap") cfg.rules.eatCap = (int)v;
+    else if (key == "move_cost") cfg.rules.moveCost = (int)v;
+    else if (key == "existence_cost") cfg.rules.existenceCost = (int)v;
+    else if (key == "corpse_organic") cfg.rules.corpseOrganic = (int)v;
+    else if (key == "divide_min_energy") cfg.rules.divideMinEnergy = (int)v;
+    else if (key == "divide_cost") cfg.rules.divideCost = (int)v;
+    else if (key == "mutation_threshold") cfg.rules.mutationThreshold = (uint32_t)std::min(std::max(v, 0LL), 0xFFFFFFFFLL);
+    else if (key == "bounded") cfg.rules.bounded = v != 0;
+    else if (key == "generic_rules") cfg.genericRules = v != 0;
+    else {
+        std::fprintf(stderr, "config: unknown key '%s'\n", key.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Файл "ключ = значение" построчно, '#' - комментарий
+bool LoadConfigFile(SimConfig& cfg, const char* path) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) {
+        std::fprintf(stderr, "config: cannot open '%s'\n", path);
+        return false;
+    }
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        std::string text(line);
+        text = text.substr(0, text.find('#'));
+        size_t eq = text.find('=');
+        if (eq == std::string::npos) continue;
+        auto trim = [](std::string v) {
+            size_t a = v.find_first_not_of(" \t\r\n");
+            size_t b = v.find_last_not_of(" \t\r\n");
+            return a == std::string::npos ? std::string() : v.substr(a, b - a + 1);
+        };
+        ApplyConfigValue(cfg, trim(text.substr(0, eq)), trim(text.substr(eq + 1)));
+    }
+    std::fclose(f);
+    return true;
+}
+
+// --config файл, --width N, --height N, --genome N, --threads N, --seed N, --rate N, --ticks_per_frame N, --vm M,
+// --stats файл, --perf battery|balanced|max, --replay каталог, --replay_interval N, --replay_keyframes N, --pin,
+// правила: --rules classic|scarce, --command_limit N, --photosynthesis N, --eat_cap N, --move_cost N,
+// --existence_cost N, --corpse_organic N, --divide_min_energy N, --divide_cost N, --mutation_threshold N,
+// --bounded 0|1, --generic_rules 0|1.
+// Незнакомые ключи пропускаются молча: их разбирает сама программа (GUI, headless).
+void ParseArgs(SimConfig& cfg, int argc, char** argv) {
+    static const char* const kKeys[] = { "width", "height", "genome", "threads", "seed", "rate", "ticks_per_frame", "vm", "stats", "perf",
+                                         "replay", "replay_interval", "replay_keyframes", "rules", "command_limit", "photosynthesis",
+                                         "eat_cap", "move_cost", "existence_cost", "corpse_organic", "divide_min_energy",
+                                         "divide_cost", "mutation_threshold", "bounded", "generic_rules" };
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--", 2) != 0) continue;
+        std::string key = argv[i] + 2;
+        bool hasValue = i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0;
+        if (key == "pin") {
+            cfg.pinBigCores = true;
+        } else if (key == "config" && hasValue) {
+            LoadConfigFile(cfg, argv[++i]);
+        } else if (hasValue && std::find(std::begin(kKeys), std::end(kKeys), key) != std::end(kKeys)) {
+            ApplyConfigValue(cfg, key, argv[++i]);
+        }
+    }
+}
+
+// Приводит параметры к допустимым границам
+void ClampConfig(SimConfig& cfg) {
+    cfg.worldW = std::max(cfg.worldW, MIN_WORLD_SIDE);
+    cfg.worldH = std::max(cfg.worldH, MIN_WORLD_SIDE);
+    if ((long long)cfg.worldW * cfg.worldH > MAX_WORLD_CELLS) {
+        std::fprintf(stderr, "config: %dx%d is too large, clamping height\n", cfg.worldW, cfg.worldH);
+        cfg.worldH = std::max(MIN_WORLD_SIDE, MAX_WORLD_CELLS / cfg.worldW);
+    }
+    cfg.genomeSize = std::min(std::max(cfg.genomeSize, MIN_GENOME_SIZE), MAX_GENOME_SIZE);
+    cfg.threads = std::max(cfg.threads, 0);
+    cfg.vm = std::min(std::max(cfg.vm, (int)VM_MODE_SCALAR), (int)VM_MODE_CHECK);
+    cfg.tickRate = std::max(cfg.tickRate, 0);
+    cfg.ticksPerFrame = std::max(cfg.ticksPerFrame, 0);
+    cfg.perf = std::min(std::max(cfg.perf, -1), (int)PERF_MODE_COUNT - 1);
+    cfg.replayInterval = std::max(cfg.replayInterval, 1);
+    cfg.replayKeyframes = std::max(cfg.replayKeyframes, 1);
+    SimRules& r = cfg.rules;
+    auto clampRule = [](int& v) { v = std::min(std::max(v, 0), MAX_RULE_VALUE); };
+    r.commandLimit = std::min(std::max(r.commandLimit, 1), MAX_COMMAND_LIMIT);
+    clampRule(r.photosynthesis);
+    clampRule(r.eatCap);
+    clampRule(r.moveCost);
+    clampRule(r.existenceCost);
+    clampRule(r.corpseOrganic);
+    clampRule(r.divideMinEnergy);
+    clampRule(r.divideCost);
+}
+
+WorldGeometry world;
+WorldPartition worldPartition;
+int genomeSize = 64;
+
+WorldBuffer worldGrid;
+GenomePool genomePool;
+
+uint64_t GenomePool::Fingerprint(const unsigned char* genome) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (int g = 0; g < genomeSize; g++) h = (h ^ genome[g]) * 1099511628211ull;
+    return h;
+}
+
+// Пул растёт пачками по GENOME_SLAB слотов: новые сразу уходят в freeSlots, и мутанты
+// в обычный тик берут готовый слот, а не расширяют массивы
+int GenomePool::Alloc() {
+    if (freeSlots.empty()) {
+        const int first = Slots();
+        data.resize(data.size() + (size_t)GENOME_SLAB * genomeSize);
+        code.resize(code.size() + (size_t)GENOME_SLAB * genomeSize);
+        hash.resize(hash.size() + GENOME_SLAB);
+        print.resize(print.size() + GENOME_SLAB);
+        refs.resize(refs.size() + GENOME_SLAB, 0);
+        sensesOrganic.resize(sensesOrganic.size() + GENOME_SLAB, 0);
+        for (int slot = first + GENOME_SLAB - 1; slot >= first; slot--) freeSlots.push_back(slot);
+    }
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+}
+
+void GenomePool::Compile(int slot) {
+    const unsigned char* genome = Get(slot);
+    VmStep* steps = &code[(size_t)slot * genomeSize];
+    CompileGenome(genome, genomeSize, steps);
+    sensesOrganic[slot] = 0;
+    for (int ip = 0; ip < genomeSize; ip++) sensesOrganic[slot] |= steps[ip].op == VM_OP_SENSE_ORGANIC;
+    uint32_t h = 2166136261u; // FNV-1a, свёрнутый в байт
+    for (int g = 0; g < genomeSize; g++) h = (h ^ genome[g]) * 16777619u;
+    hash[slot] = (unsigned char)(h ^ h >> 8 ^ h >> 16 ^ h >> 24);
+}
+
+int GenomePool::Intern(const unsigned char* genome) {
+    const uint64_t key = Fingerprint(genome);
+    auto range = index.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (std::memcmp(Get(it->second), genome, genomeSize) == 0) {
+            refs[it->second]++;
+            return it->second;
+        }
+    }
+    int slot = Alloc();
+    std::memcpy(&data[(size_t)slot * genomeSize], genome, genomeSize);
+    print[slot] = key;
+    refs[slot] = 1;
+    index.emplace(key, slot);
+    Compile(slot);
+    organicSensors += sensesOrganic[slot];
+    return slot;
+}
+
+int GenomePool::Find(uint64_t key) const {
+    auto range = index.equal_range(key);
+    if (range.first == range.second || std::next(range.first) != range.second) return -1;
+    return range.first->second;
+}
+
+void GenomePool::Drop(int slot) {
+    auto range = index.equal_range(print[slot]);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == slot) {
+            index.erase(it);
+            break;
+        }
+    }
+    organicSensors -= sensesOrganic[slot];
+    freeSlots.push_back(slot);
+}
+
+void GenomePool::Recount(const std::vector<unsigned char>& alive, const std::vector<int>& genome, int cells) {
+    std::fill(refs.begin(), refs.end(), 0);
+    for (int i = 0; i < cells; i++) {
+        if (alive[i]) refs[genome[i]]++;
+    }
+    index.clear();
+    freeSlots.clear();
+    organicSensors = 0;
+    for (int slot = Slots() - 1; slot >= 0; slot--) {
+        if (refs[slot]) {
+            index.emplace(print[slot], slot);
+            organicSensors += sensesOrganic[slot];
+        } else {
+            freeSlots.push_back(slot);
+        }
+    }
+}
+
+std::atomic<int> aliveCount{0};
+ThreadPool workerPool(1);
+static std::vector<double> workerBusy; // Загрузка воркеров за последний тик
+
+// Индекс направления по смещению (-1..1, -1..1); -1 для (0, 0)
+inline int DirIndex(int dx, int dy) {
+    static const int table[3][3] = {
+        { 7, 0, 1 },  // dy = -1
+        { 6, -1, 2 }, // dy = 0
+        { 5, 4, 3 },  // dy = 1
+    };
+    return table[dy + 1][dx + 1];
+}
+
+uint32_t worldSeed = 12345;
+
+uint32_t OrganicKey(unsigned tick) { return RngKey(worldSeed, tick, RNG_STREAM_ORGANIC); }
+
+// Случайный прирост органики на месте. Сетка не копируется: хэш считается для всех клеток
+// (чистая арифметика без обращений к памяти, векторизуется пачками по GROWTH_BATCH),
+// а organic/alive трогаются только в редких выпавших клетках (~1 из 1001).
+// Возвращает, сколько клеток получили органику.
+const int GROWTH_BATCH = 64;
+
+static int GrowOrganic(int* organic, const unsigned char* alive, uint32_t firstCell, int count, uint32_t key) {
+    int grown = 0;
+    for (int base = 0; base < count; base += GROWTH_BATCH) {
+        int n = std::min(GROWTH_BATCH, count - base);
+        unsigned char hit[GROWTH_BATCH];
+        unsigned char any = 0;
+        for (int i = 0; i < n; i++) {
+            hit[i] = CellRandom(key, firstCell + (uint32_t)(base + i)) < ORGANIC_GROWTH_THRESHOLD;
+            any |= hit[i];
+        }
+        if (!any) continue;
+        for (int i = 0; i < n; i++) {
+            if (hit[i] && !alive[base + i]) {
+                organic[base + i] += ORGANIC_GROWTH;
+                grown++;
+            }
+        }
+    }
+    return grown;
+}
+
+// --- ДИФФУЗИЯ ОРГАНИКИ ---
+// Стенсил читает соседей, поэтому пишет во второй буфер, который затем меняется местами
+// с worldGrid.organic (обмен указателей, без копирования). Полосы строк - по воркерам.
+static std::vector<int> organicNext;
+static std::vector<long long> workerDecayed; // Распад по воркерам: сводится после прохода
+
+inline int DiffuseCell(int c, int left, int right, int up, int down, long long& decayed) {
+    const int s = ORGANIC_DIFFUSE_SHIFT;
+    int v = c - 4 * (c >> s) + (left >> s) + (right >> s) + (up >> s) + (down >> s);
+    int d = v >> ORGANIC_DECAY_SHIFT;
+    decayed += d;
+    return v - d;
+}
+
+// Внутренние клетки строки - плотный цикл без переходов (векторизуется), края - по тору.
+// В мире с краями сосед за краем - сама клетка: отдала и получила ту же долю, масса на месте
+static long long DiffuseRow(const int* up, const int* row, const int* down, int* out, int w, bool bounded) {
+    long long decayed = 0;
+    out[0] = DiffuseCell(row[0], row[bounded ? 0 : w - 1], row[1], up[0], down[0], decayed);
+    for (int x = 1; x < w - 1; x++) {
+        out[x] = DiffuseCell(row[x], row[x - 1], row[x + 1], up[x], down[x], decayed);
+    }
+    out[w - 1] = DiffuseCell(row[w - 1], row[w - 2], row[bounded ? w - 1 : 0], up[w - 1], down[w - 1], decayed);
+    return decayed;
+}
+
+// Возвращает распавшуюся органику (для суммарной статистики)
+static long long DiffuseOrganic() {
+    const int w = world.w, h = world.h;
+    const bool bounded = simRules.bounded;
+    organicNext.resize(world.cells);
+    workerDecayed.assign(workerPool.Size(), 0);
+    const int* src = worldGrid.organic.data();
+    int* dst = organicNext.data();
+    workerPool.ParallelFor(0, h, [&](int y0, int y1, int worker) {
+        long long decayed = 0;
+        for (int y = y0; y < y1; y++) {
+            const int* row = src + (size_t)y * w;
+            const int* up = y > 0 ? row - w : bounded ? row : src + (size_t)(h - 1) * w;
+            const int* down = y < h - 1 ? row + w : bounded ? row : src;
+            decayed += DiffuseRow(up, row, down, dst + (size_t)y * w, w, bounded);
+        }
+        workerDecayed[worker] += decayed;
+    });
+    worldGrid.organic.swap(organicNext);
+    long long decayed = 0;
+    for (long long d : workerDecayed) decayed += d;
+    return decayed;
+}
+
+// --- НАМЕРЕНИЯ (ДВУХФАЗНЫЙ ТИК) ---
+// Состояние мира одно, второго буфера сетки нет: его роль играют намерения - компактная
+// копия изменяемой части бота (энергия, ip, направление, цвет). Геномы и прочее неизменное за тик не копируются.
+// Фаза 1: VM только читает сетку и пишет намерение бота в буфер своего тайла.
+// Фаза 2: намерения разрешаются и применяются на месте. Спор за клетку решает наименьший
+// индекс клетки-источника, поэтому результат не зависит ни от числа потоков, ни от их порядка.
+// Сами намерения (BotIntent) и VM, которая их пишет, - в vm.h.
+
+// Заявки на клетки: минимальный src среди претендентов за тик tick.
+// Заявка с чужим tick считается пустой, поэтому сбрасывать массив не нужно.
+// Для занятой клетки заявка означает атаку, для свободной - движение или деление.
+struct CellClaim {
+    unsigned tick;
+    int src;
+};
+std::vector<CellClaim> cellClaims;
+unsigned worldTick = 0;
+
+inline bool HasClaim(int cell) { return cellClaims[cell].tick == worldTick; }
+
+// --- ТАЙЛЫ ---
+// Мир режется на тайлы ~64x64 - это единица работы для всех фаз тика.
+// У каждого тайла свой список ботов, буфер намерений и исходящие списки для 8 соседей:
+// бот, ушедший через границу, явно передаётся соседу (обмен гало), а не пишется в чужой список.
+// Заявки пишутся без атомиков: фаза заявок идёт по цветам шахматной раскраски,
+// и одновременно работают только тайлы, которые не соседствуют (их кольца в 1 клетку не пересекаются).
+const int TILE_SIZE = 64;
+const int MAX_TILE_COLORS = 9; // 3x3: третий цвет нужен при нечётном числе тайлов по оси
+
+// Счётчики тайла за тик: пишет только задача этого тайла, сводит фаза слияния
+struct TileCounters {
+    int births = 0, deaths = 0, photosynthesis = 0, predation = 0, scavenging = 0, moves = 0;
+    long long energy = 0;  // Энергия выживших ботов и потомков
+    long long organic = 0; // Изменение суммарной органики
+};
+
+// Потомок, родившийся в фазе 2. Ссылку на геном (и мутантный слот) оформляет фаза слияния:
+// пул геномов меняется только в одном потоке
+struct Birth {
+    int cell;
+    int parent;          // Слот генома родителя
+    int mutateAt;        // Байт генома под мутацию, -1 - точная копия
+    unsigned char value; // Новое значение байта
+};
+
+struct Tile {
+    int index;                 // Номер тайла - он же номер блока SpatialIndex
+    int x0, y0, x1, y1;        // Клетки [x0, x1) x [y0, y1)
+    int neighbors[8];          // Соседний тайл по направлению DIR_X/DIR_Y
+    std::vector<int> bots;     // Клетки ботов тайла
+    std::vector<BotIntent> intents;
+    std::vector<int> outbox[8];// Боты, перешедшие в соседний тайл по направлению d
+    std::vector<int> freed;    // Слоты геномов погибших ботов (ссылки отпускаются в фазе слияния)
+    std::vector<Birth> births; // Потомки за тик; как и прочие буферы тайла, память переиспользуется
+    std::vector<ReplayEvent> events; // События тика для журнала (replay.h), только при replayRecorder
+    TileCounters counters;     // Статистика тайла за тик (stats.h)
+    bool viewDirty = true;     // Клетки тайла (и соседние на шаг) менялись для снимка; сбрасывает BuildSnapshot
+};
+
+// Задача фазы 1: боты [begin, end) тайла. Плотный тайл режется на куски по THINK_CHUNK_BOTS,
+// чтобы кластер хищников не оставался одной задачей на одном воркере; рост органики тайла
+// делает кусок с begin == 0 (он есть и у пустого тайла)
+struct ThinkTask {
+    int tile;
+    int begin, end;
+};
+
+const int THINK_CHUNK_BOTS = 1024;
+static std::vector<ThinkTask> thinkTasks;
+static std::vector<double> workerGrowMs, workerVmMs; // Процессорное время фазы 1 по воркерам (для профайлера)
+
+int tilesX = 1, tilesY = 1;
+int tileW = TILE_SIZE, tileH = TILE_SIZE;
+int tileShiftX = -1, tileShiftY = -1; // Для мира-степени двойки тайлы тоже степени двойки
+std::vector<Tile> tiles;
+std::vector<int> tilesByColor[MAX_TILE_COLORS];
+
+// Цвет по оси: чередование 0/1, последний тайл нечётного ряда получает 2 (иначе на стыке тора совпадут)
+inline int AxisColor(int t, int count) {
+    if (count == 1) return 0;
+    if (count % 2 == 1 && t == count - 1) return 2;
+    return t % 2;
+}
+
+inline int TileX(int x) { return tileShiftX >= 0 ? (x >> tileShiftX) : (x / tileW); }
+inline int TileY(int y) { return tileShiftY >= 0 ? (y >> tileShiftY) : (y / tileH); }
+inline int TileOf(int cell) { return TileY(world.Y(cell)) * tilesX + TileX(world.X(cell)); }
+
+inline int Log2IfPow2(int v) {
+    if (v & (v - 1)) return -1;
+    int s = 0;
+    while ((1 << s) < v) s++;
+    return s;
+}
+
+void BuildTiles() {
+    // Размеры выравниваются, чтобы последний тайл не получился шириной в 1 клетку
+    tilesX = (world.w + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (world.h + TILE_SIZE - 1) / TILE_SIZE;
+    tileW = (world.w + tilesX - 1) / tilesX;
+    tileH = (world.h + tilesY - 1) / tilesY;
+    tileShiftX = (tileW * tilesX == world.w) ? Log2IfPow2(tileW) : -1;
+    tileShiftY = (tileH * tilesY == world.h) ? Log2IfPow2(tileH) : -1;
+
+    tiles.assign(tilesX * tilesY, Tile());
+    for (auto& list : tilesByColor) list.clear();
+
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            Tile& tile = tiles[ty * tilesX + tx];
+            tile.index = ty * tilesX + tx;
+            tile.x0 = tx * tileW;
+            tile.y0 = ty * tileH;
+            tile.x1 = std::min(world.w, tile.x0 + tileW);
+            tile.y1 = std::min(world.h, tile.y0 + tileH);
+            for (int d = 0; d < 8; d++) {
+                int nx = (tx + DIR_X[d] + tilesX) % tilesX;
+                int ny = (ty + DIR_Y[d] + tilesY) % tilesY;
+                tile.neighbors[d] = ny * tilesX + nx;
+            }
+            tilesByColor[AxisColor(ty, tilesY) * 3 + AxisColor(tx, tilesX)].push_back(ty * tilesX + tx);
+        }
+    }
+}
+
+// Фаза 2 тайла под правила мира (определение - после CommitBot); выбирается в AllocateWorld
+template <class R>
+static void CommitTile(Tile& tile, uint32_t mutationKey);
+static void (*commitTile)(Tile& tile, uint32_t mutationKey) = CommitTile<ClassicRules<false>>;
+
+// --- ГЕНЕРАЦИЯ ---
+// Память выделяется под выбранный размер мира
+void AllocateWorld() {
+    world.Set(config.worldW, config.worldH);
+    world.globalBase = worldPartition.cells > 0 ? worldPartition.base : 0;
+    world.globalCells = worldPartition.cells > 0 ? worldPartition.cells : world.cells;
+    genomeSize = config.genomeSize;
+
+    worldSeed = config.seed;
+    vmMode = (VmMode)config.vm;
+    SetVmRules(config.rules, !config.genericRules); // До genomePool: лимит команд входит в код геномов
+    WithRules(simRules, !config.genericRules, [](auto r) { commitTile = CommitTile<decltype(r)>; });
+
+    worldGrid.Resize(world.cells);
+    genomePool = GenomePool();
+    cellClaims.assign(world.cells, CellClaim{0, 0});
+    worldTick = 1;
+    BuildTiles();
+}
+
+// --- СТАТИСТИКА ---
+// Суммарная органика ведётся приращениями тайлов; полный пересчёт - только при смене мира
+static long long organicTotal = 0;
+
+static void ResetStatsTotals() {
+    organicTotal = 0;
+    for (int i = 0; i < world.cells; i++) organicTotal += worldGrid.organic[i];
+    tickStats = TickStats();
+    tickStats.tick = worldTick - 1;
+    tickStats.alive = aliveCount;
+    tickStats.organic = organicTotal;
+    tickStats.genomes = genomePool.Unique();
+}
+
+void InitWorld() {
+    AllocateWorld();
+    const uint32_t cellKey = RngKey(worldSeed, 0, RNG_STREAM_INIT_CELL);
+    const uint32_t genomeKey = RngKey(worldSeed, 0, RNG_STREAM_INIT_GENOME);
+
+    for (int i = 0; i < world.cells; i++) {
+        uint32_t r = CellRandom(cellKey, world.GlobalCell(i));
+        worldGrid.organic[i] = (r & 0xFF) % 50; // Немного органики везде
+        
+        // Спавним ботов (примерно 20% заполнения)
+        if (((r >> 8) & 0xFF) > 200) {
+            worldGrid.alive[i] = 1;
+            worldGrid.energy[i] = 500;
+            worldGrid.born[i] = worldTick;
+            worldGrid.dir[i] = (r >> 16) % 8;
+            unsigned char genome[MAX_GENOME_SIZE];
+            CounterRng genomeRng(genomeKey, world.GlobalCell(i));
+            for (int g = 0; g < genomeSize; g++) {
+                genome[g] = (unsigned char)genomeRng.Next();
+            }
+            worldGrid.genome[i] = genomePool.Intern(genome);
+            tiles[TileOf(i)].bots.push_back(i);
+        }
+    }
+
+    spatialIndex.Rebuild(worldGrid, world.w, world.h, tileW, tileH, simRules.bounded, workerPool);
+    aliveCount = spatialIndex.Alive();
+    ResetStatsTotals();
+}
+
+void RebuildBotLists() {
+    for (Tile& tile : tiles) {
+        tile.bots.clear();
+        tile.freed.clear();
+        tile.births.clear();
+        tile.events.clear();
+        tile.viewDirty = true;
+    }
+    for (int i = 0; i < world.cells; i++) {
+        if (worldGrid.alive[i]) tiles[TileOf(i)].bots.push_back(i);
+    }
+    genomePool.Recount(worldGrid.alive, worldGrid.genome, world.cells);
+    spatialIndex.Rebuild(worldGrid, world.w, world.h, tileW, tileH, simRules.bounded, workerPool);
+    aliveCount = spatialIndex.Alive();
+    ResetStatsTotals();
+}
+
+void RefreshRows(int r0, int rows, int aliveDelta, long long organicDelta) {
+    const int first = r0 * world.w, end = (r0 + rows) * world.w;
+    // Строки режут тайлы: из списков уходят только клетки этих строк
+    for (int ty = TileY(r0); ty <= TileY(r0 + rows - 1); ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            Tile& tile = tiles[ty * tilesX + tx];
+            std::vector<int>& bots = tile.bots;
+            bots.erase(std::remove_if(bots.begin(), bots.end(), [&](int c) { return c >= first && c < end; }), bots.end());
+            spatialIndex.MarkOrganic(tile.index);
+            tile.viewDirty = true;
+        }
+    }
+    for (int c = first; c < end; c++) {
+        if (worldGrid.alive[c]) {
+            tiles[TileOf(c)].bots.push_back(c);
+            spatialIndex.SetOccupied(c);
+        } else {
+            spatialIndex.ClearOccupied(c);
+        }
+    }
+    // Следующий тик читает суммы органики до того, как их обновит его собственный проход
+    if (genomePool.organicSensors > 0) spatialIndex.RefreshOrganic(worldGrid, workerPool);
+    aliveCount += aliveDelta;
+    organicTotal += organicDelta;
+}
+
+// Фаза 2: применение намерения на месте. Каждую клетку пишет ровно один бот:
+// src - сам бот (ушёл, умер или остался), target - только победитель заявки.
+// Энергию жертвы никто, кроме её убийцы, в этой фазе не трогает, поэтому её можно читать из чужого тайла.
+// Возвращает клетку, где бот оказался, или -1 если бот умер; child - клетка потомка или -1.
+template <class R>
+static int CommitBot(const R& rules, const BotIntent& in, WorldBuffer& grid, Tile& tile, uint32_t mutationKey, int& child) {
+    std::vector<int>& freed = tile.freed;
+    TileCounters& stats = tile.counters;
+    child = -1;
+    const bool record = replayRecorder != nullptr;
+    if (in.action == ACTION_DIE) {
+        if (record) tile.events.push_back(ReplayEvent{ (uint32_t)in.src, REPLAY_DEATH, 0, 0 });
+        grid.alive[in.src] = 0;
+        spatialIndex.ClearOccupied(in.src);
+        spatialIndex.MarkOrganic(tile.index);
+        tile.viewDirty = true;
+        grid.organic[in.src] += rules.corpseOrganic; // Труп разлагается
+        freed.push_back(in.genome);
+        stats.deaths++;
+        stats.organic += rules.corpseOrganic;
+        return -1;
+    }
+
+    // Бота съел сосед: его собственное намерение уже не выполняется
+    if (HasClaim(in.src)) {
+        if (record) tile.events.push_back(ReplayEvent{ (uint32_t)in.src, REPLAY_EATEN, 0, 0 });
+        grid.alive[in.src] = 0;
+        spatialIndex.ClearOccupied(in.src);
+        tile.viewDirty = true;
+        freed.push_back(in.genome);
+        stats.deaths++;
+        return -1;
+    }
+
+    int pos = in.src;
+    int energy = in.energy;
+    bool won = in.target >= 0 && cellClaims[in.target].src == in.src;
+    auto event = [&](ReplayEventKind kind) {
+        if (record) tile.events.push_back(ReplayEvent{ (uint32_t)in.src, kind, in.dir, 0 });
+    };
+
+    if (in.action == ACTION_MOVE && won) {
+        pos = in.target; // Переносим бота
+        energy -= rules.moveCost; // Трата на движение
+        grid.alive[in.src] = 0;
+        spatialIndex.ClearOccupied(in.src);
+        spatialIndex.SetOccupied(pos);
+        tile.viewDirty = true; // Клетка pos - в этом тайле или на шаг за ним
+        stats.moves++;
+        event(REPLAY_MOVE);
+    } else if (in.action == ACTION_ATTACK && won) {
+        energy += grid.energy[in.target] / 2; // Жертва умирает, её энергия наша
+        stats.predation++;
+        event(REPLAY_ATTACK);
+    } else if (in.action == ACTION_DIVIDE && won) {
+        energy -= rules.divideCost;
+        int childEnergy = energy / 2;
+        energy -= childEnergy;
+        child = in.target;
+        grid.alive[child] = 1;
+        spatialIndex.SetOccupied(child);
+        tile.viewDirty = true;
+        grid.energy[child] = childEnergy;
+        grid.ip[child] = 0;
+        grid.dir[child] = in.dir;
+        grid.color[child] = in.color;
+        grid.genome[child] = in.genome; // Мутантный слот подставит фаза слияния
+        grid.born[child] = worldTick;
+        stats.births++;
+        stats.energy += childEnergy;
+        event(REPLAY_BIRTH); // Отпечаток генома потомка допишет фаза слияния
+        // Случайность по клетке родителя: цена не зависит ни от потока, ни от числа рождений
+        CounterRng rng(mutationKey, world.GlobalCell(in.src));
+        int mutateAt = rng.Next() < rules.mutationThreshold ? (int)(rng.Next() % (uint32_t)genomeSize) : -1;
+        tile.births.push_back(Birth{ child, in.genome, mutateAt, (unsigned char)rng.Next() });
+    }
+    stats.photosynthesis += in.op == VM_OP_PHOTOSYNTHESIS;
+    stats.scavenging += in.eaten > 0;
+    stats.organic -= in.eaten;
+    stats.energy += energy;
+
+    grid.organic[in.src] -= in.eaten;
+    if (in.eaten) spatialIndex.MarkOrganic(tile.index);
+    if (in.eaten || in.color != grid.color[in.src]) tile.viewDirty = true;
+    grid.alive[pos] = 1;
+    grid.energy[pos] = energy;
+    grid.ip[pos] = in.ip;
+    grid.dir[pos] = in.dir;
+    grid.color[pos] = in.color;
+    grid.genome[pos] = in.genome;
+    if (pos != in.src) grid.born[pos] = grid.born[in.src]; // src пишет только сам бот
+    return pos;
+}
+
+// Фаза 2 одного тайла. Бот, перешедший в соседний тайл, уходит в outbox соответствующего направления.
+// Как и ход бота, шаблон по правилам: commitTile выбирается вместе с ядром VM в AllocateWorld
+template <class R>
+static void CommitTile(Tile& tile, uint32_t mutationKey) {
+    const R rules(simRules);
+    for (auto& out : tile.outbox) out.clear();
+    tile.bots.clear();
+    // Бот (или потомок) в клетке cell - в свой список или соседу; клетка та же или соседняя по dir
+    auto place = [&](int cell, const BotIntent& intent) {
+        int crossX = TileX(world.X(cell)) == TileX(world.X(intent.src)) ? 0 : DIR_X[intent.dir];
+        int crossY = TileY(world.Y(cell)) == TileY(world.Y(intent.src)) ? 0 : DIR_Y[intent.dir];
+        if (crossX == 0 && crossY == 0) tile.bots.push_back(cell);
+        else tile.outbox[DirIndex(crossX, crossY)].push_back(cell);
+    };
+    for (const BotIntent& intent : tile.intents) {
+        int child;
+        int pos = CommitBot(rules, intent, worldGrid, tile, mutationKey, child);
+        if (pos >= 0) place(pos, intent);
+        if (child >= 0) place(child, intent);
+    }
+}
+
+// --- ОБНОВЛЕНИЕ МИРА (МНОГОПОТОЧНОЕ) ---
+void UpdateWorld() {
+    const int tileCount = (int)tiles.size();
+
+    const uint32_t organicKey = OrganicKey(worldTick);
+    const uint32_t mutationKey = RngKey(worldSeed, worldTick, RNG_STREAM_MUTATION);
+    typedef ProfScope::Clock Clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    ProfScope tickScope(PROF_TICK);
+
+    // Фаза 1 (по кускам тайлов): рост органики в своих клетках и VM своих ботов.
+    // Рост трогает только пустые клетки, а VM читает органику только под ботами - гонки нет.
+    {
+        ProfScope scope(PROF_THINK);
+        thinkTasks.clear();
+        for (int t = 0; t < tileCount; t++) {
+            Tile& tile = tiles[t];
+            const int bots = (int)tile.bots.size();
+            tile.intents.resize(bots); // Буфер переиспользуется между тиками; куски пишут свои отрезки
+            int begin = 0;
+            do {
+                int end = std::min(bots, begin + THINK_CHUNK_BOTS);
+                thinkTasks.push_back(ThinkTask{ t, begin, end });
+                begin = end;
+            } while (begin < bots);
+        }
+        workerGrowMs.assign(workerPool.Size(), 0.0);
+        workerVmMs.assign(workerPool.Size(), 0.0);
+        workerPool.ForEachTask((int)thinkTasks.size(), [&](int i, int worker) {
+            const ThinkTask& task = thinkTasks[i];
+            Tile& tile = tiles[task.tile];
+            WorldBuffer& grid = worldGrid;
+            Clock::time_point start = Clock::now();
+            if (task.begin == 0) {
+                tile.counters = TileCounters();
+                int grownCells = 0;
+                for (int y = tile.y0; y < tile.y1; y++) {
+                    int first = y * world.w + tile.x0;
+                    grownCells += GrowOrganic(&grid.organic[first], &grid.alive[first], world.GlobalCell(first), tile.x1 - tile.x0,
+                                              organicKey);
+                }
+                tile.counters.organic += (long long)grownCells * ORGANIC_GROWTH;
+                if (grownCells) {
+                    spatialIndex.MarkOrganic(tile.index);
+                    tile.viewDirty = true;
+                }
+            }
+            Clock::time_point grown = Clock::now();
+
+            // У пустого тайла списки пусты: VM и фаза 2 для него ничего не стоят
+            RunBots(tile.bots.data() + task.begin, task.end - task.begin, grid, tile.intents.data() + task.begin);
+            workerGrowMs[worker] += ms(grown - start);
+            workerVmMs[worker] += ms(Clock::now() - grown);
+        });
+    }
+
+    // Фаза 1b: заявки на клетки, цвет за цветом. Соседние тайлы никогда не работают одновременно
+    {
+        ProfScope scope(PROF_CLAIM);
+        for (const auto& colorTiles : tilesByColor) {
+            workerPool.ForEachTask((int)colorTiles.size(), [&](int i, int) {
+                for (const BotIntent& intent : tiles[colorTiles[i]].intents) {
+                    if (intent.target < 0) continue;
+                    CellClaim& claim = cellClaims[intent.target];
+                    if (claim.tick != worldTick || world.GlobalCell(intent.src) < world.GlobalCell(claim.src)) {
+                        claim = CellClaim{worldTick, intent.src};
+                    }
+                }
+            });
+        }
+    }
+
+    // Фаза 2 (по тайлам): разрешение заявок и запись в сетку
+    {
+        ProfScope scope(PROF_COMMIT);
+        workerPool.ForEachTask(tileCount, [&](int t, int) { commitTile(tiles[t], mutationKey); });
+    }
+
+    // Фаза 2b (по тайлам): обмен границей - забираем ботов, пришедших от соседей
+    {
+        ProfScope scope(PROF_GATHER);
+        workerPool.ForEachTask(tileCount, [&](int t, int) {
+            Tile& tile = tiles[t];
+            for (int d = 0; d < 8; d++) {
+                const std::vector<int>& in = tiles[tile.neighbors[d]].outbox[(d + 4) % 8];
+                tile.bots.insert(tile.bots.end(), in.begin(), in.end());
+            }
+        });
+    }
+
+    // Органика растекается и гниёт отдельным проходом после всех записей тика
+    long long decayed = 0;
+    if (worldTick % ORGANIC_DIFFUSION_INTERVAL == 0) {
+        ProfScope scope(PROF_DIFFUSE);
+        decayed = DiffuseOrganic();
+        spatialIndex.MarkAllOrganic();
+        for (Tile& tile : tiles) tile.viewDirty = true;
+    }
+
+    {
+        ProfScope scope(PROF_MERGE);
+        double growMs = 0, vmMs = 0;
+        for (double t : workerGrowMs) growMs += t;
+        for (double t : workerVmMs) vmMs += t;
+        TickStats stats = TickStats();
+        unsigned char mutant[MAX_GENOME_SIZE];
+        tickEvents.clear();
+        for (Tile& tile : tiles) {
+            // Сначала потомки: родитель жив, так что его слот не освободится раньше времени
+            for (const Birth& birth : tile.births) {
+                if (birth.mutateAt < 0 || genomePool.Get(birth.parent)[birth.mutateAt] == birth.value) {
+                    genomePool.Retain(birth.parent);
+                    continue;
+                }
+                std::memcpy(mutant, genomePool.Get(birth.parent), genomeSize);
+                mutant[birth.mutateAt] = birth.value;
+                worldGrid.genome[birth.cell] = genomePool.Intern(mutant);
+            }
+            if (replayRecorder) {
+                // Рождения в событиях тайла идут в том же порядке, что и tile.births
+                size_t b = 0;
+                for (ReplayEvent& e : tile.events) {
+                    if (e.kind == REPLAY_BIRTH) e.genome = genomePool.print[worldGrid.genome[tile.births[b++].cell]];
+                }
+                tickEvents.insert(tickEvents.end(), tile.events.begin(), tile.events.end());
+                tile.events.clear();
+            }
+            tile.births.clear();
+            for (int slot : tile.freed) genomePool.Release(slot);
+            tile.freed.clear();
+            const TileCounters& c = tile.counters;
+            stats.births += c.births;
+            stats.deaths += c.deaths;
+            stats.photosynthesis += c.photosynthesis;
+            stats.predation += c.predation;
+            stats.scavenging += c.scavenging;
+            stats.moves += c.moves;
+            stats.energy += c.energy;
+            organicTotal += c.organic;
+        }
+        const int alive = aliveCount + stats.births - stats.deaths; // Съеденные - тоже в deaths
+        aliveCount = alive;
+        profiler.Record(PROF_GROW_CPU, growMs);
+        profiler.Record(PROF_VM_CPU, vmMs);
+
+        stats.tick = worldTick;
+        stats.alive = alive;
+        organicTotal -= decayed;
+        stats.organic = organicTotal;
+        stats.genomes = genomePool.Unique();
+        tickStats = stats;
+        if (statsRecorder) statsRecorder->Push(stats);
+    }
+
+    // Суммы органики для команд-запросов следующего тика. Занятость фаза 2 уже обновила сама.
+    // После слияния: мутант, впервые спросивший органику, появляется именно там
+    {
+        ProfScope scope(PROF_SENSE);
+        if (genomePool.organicSensors > 0) spatialIndex.RefreshOrganic(worldGrid, workerPool);
+    }
+    worldTick++;
+    if (replayRecorder) replayRecorder->Record(worldTick - 1, tickEvents);
+
+    // Загрузка воркеров за тик (включая снимок для рендера, если он строился после прошлого тика)
+    workerPool.TakeBusyStats(workerBusy);
+    profiler.RecordWorkers(workerBusy);
+}
+
+uint64_t WorldChecksum() {
+    const WorldBuffer& grid = worldGrid;
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    auto mix = [&](uint64_t v) {
+        h ^= v;
+        h *= 1099511628211ull;
+    };
+    for (int i = 0; i < world.cells; i++) {
+        mix((uint32_t)grid.organic[i]);
+        if (!grid.alive[i]) continue;
+        mix((uint64_t)i);
+        mix((uint32_t)grid.energy[i]);
+        mix(grid.ip[i] | grid.dir[i] << 8 | grid.color[i] << 16);
+        const unsigned char* genome = genomePool.Get(grid.genome[i]);
+        for (int g = 0; g < genomeSize; g++) mix(genome[g]);
+    }
+    return h;
+}
+
+std::string RunDescription() {
+    char buf[320];
+    std::snprintf(buf, sizeof(buf), "device=%s world=%dx%d genome=%d threads=%d pin=%d seed=%u tick=%u alive=%d rules=%s",
+                  DeviceDescription().c_str(), world.w, world.h, genomeSize, workerPool.Size(),
+                  workerPool.PinBigCores() ? 1 : 0, config.seed, worldTick, (int)aliveCount, VmRulesKernel());
+    return buf;
+}
+
+// --- СНИМОК ДЛЯ ОТРИСОВКИ ---
+// Последнее опубликованное содержимое и версии блоков. Слоты тройного буфера отстают
+// на несколько снимков, поэтому догоняются из этой копии, а не из сетки.
+// publishedDirty - блок менялся после того, как его последний раз пересобрали из сетки.
+static std::vector<unsigned char> publishedCells;
+static std::vector<unsigned> publishedVersion;
+static std::vector<unsigned char> publishedDirty;
+static SnapshotView publishedView = VIEW_ORGANIC;
+static unsigned snapshotSeq = 0;
+
+SnapshotView snapshotView = VIEW_ORGANIC;
+int snapshotLodLevels = 0;
+SnapshotRect snapshotVisible;
+
+const char* ViewName(SnapshotView view) {
+    switch (view) {
+    case VIEW_ENERGY: return "energy";
+    case VIEW_GENOME: return "genome";
+    case VIEW_AGE: return "age";
+    default: return "organic";
+    }
+}
+
+// Второй байт клетки-бота в режимах, отличных от VIEW_ORGANIC
+static unsigned char ViewValue(SnapshotView view, const WorldBuffer& grid, int i) {
+    switch (view) {
+    case VIEW_ENERGY: return (unsigned char)std::min(std::max(grid.energy[i], 0) >> VIEW_ENERGY_SHIFT, 255);
+    case VIEW_GENOME: return genomePool.hash[grid.genome[i]];
+    case VIEW_AGE: return (unsigned char)std::min((worldTick - grid.born[i]) >> VIEW_AGE_SHIFT, 255u);
+    default: return (unsigned char)std::min(std::max(grid.organic[i], 0), 255);
+    }
+}
+
+int LodLevelCount(int w, int h) {
+    int levels = 0;
+    while (std::max(LodSide(w, levels), LodSide(h, levels)) > LOD_TOP_SIDE) levels++;
+    return levels;
+}
+
+// Деление на 1..1020 (сумма четырёх долей) умножением: LOD считается на каждом снимке
+struct LodReciprocals {
+    uint32_t r[4 * 255 + 1];
+    LodReciprocals() {
+        r[0] = 0;
+        for (int n = 1; n <= 4 * 255; n++) r[n] = (uint32_t)((1u << 24) / n) + 1;
+    }
+    unsigned char Div(int sum, int n) const { return (unsigned char)std::min<uint64_t>(((uint64_t)sum * r[n]) >> 24, 255); }
+};
+static const LodReciprocals lodDiv;
+
+// До 4 потомков (у края мира меньше): доли - средние, значения - взвешенные по своей доле
+static LodTexel CombineTexels(const LodTexel* kids, int count, bool sample) {
+    int density = 0, green = 0, value = 0, empty = 0, organic = 0, densest = 0;
+    for (int k = 0; k < count; k++) {
+        const LodTexel& t = kids[k];
+        density += t.density;
+        green += t.density * t.green;
+        value += t.density * t.value;
+        organic += (255 - t.density) * t.organic;
+        empty += 255 - t.density;
+        if (t.density > kids[densest].density) densest = k;
+    }
+    LodTexel out;
+    out.density = lodDiv.Div(density, count);
+    out.green = lodDiv.Div(green, density);
+    out.value = sample ? kids[densest].value : lodDiv.Div(value, density);
+    out.organic = lodDiv.Div(organic, empty);
+    return out;
+}
+
+// Уровень 1 прямо из байтов клеток: у бота доля 255, у пустой клетки 0
+static LodTexel CellsTexel(const unsigned char* const* cells, int count, bool sample) {
+    int bots = 0, green = 0, value = 0, total = 0, first = 0;
+    for (int k = count - 1; k >= 0; k--) {
+        const unsigned char* c = cells[k];
+        int bot = c[0] != CELL_EMPTY;
+        bots += bot;
+        green += c[0] == CELL_BOT + BOT_COLOR_GREEN;
+        value += bot * c[1];
+        total += c[1];
+        first = bot ? c[1] : first; // Обход с конца: остаётся первый бот
+    }
+    LodTexel out;
+    out.density = lodDiv.Div(bots * 255, count);
+    out.green = lodDiv.Div(green * 255, bots);
+    out.value = sample ? (unsigned char)first : lodDiv.Div(value, bots);
+    out.organic = lodDiv.Div(total - value, count - bots);
+    return out;
+}
+
+// Уровень 1 для n полных квадратов 2x2 из пары строк (без режима выборки): без таблиц и ветвлений,
+// чтобы цикл векторизовался - это самый большой уровень.
+static void BuildLod1Row(const unsigned char* r0, const unsigned char* r1, int n, LodTexel* out) {
+    uint32_t* packed = reinterpret_cast<uint32_t*>(out); // density | green << 8 | value << 16 | organic << 24
+    for (int k = 0; k < n; k++) {
+        const unsigned char* a = r0 + 4 * k;
+        const unsigned char* c = r1 + 4 * k;
+        int b0 = a[0] != CELL_EMPTY, b1 = a[2] != CELL_EMPTY, b2 = c[0] != CELL_EMPTY, b3 = c[2] != CELL_EMPTY;
+        int bots = b0 + b1 + b2 + b3;
+        int green = (a[0] == CELL_BOT + BOT_COLOR_GREEN) + (a[2] == CELL_BOT + BOT_COLOR_GREEN) +
+                    (c[0] == CELL_BOT + BOT_COLOR_GREEN) + (c[2] == CELL_BOT + BOT_COLOR_GREEN);
+        int value = b0 * a[1] + b1 * a[3] + b2 * c[1] + b3 * c[3];
+        int organic = a[1] + a[3] + c[1] + c[3] - value;
+        // Не std::max: с ним GCC видит ветвление и не векторизует цикл
+        float perBot = 1.0f / (float)(bots + (bots == 0));
+        float perEmpty = 1.0f / (float)(4 - bots + (bots == 4));
+        int d = (bots * 255) >> 2;
+        int g = (int)(green * 255 * perBot);
+        int v = (int)(value * perBot);
+        int o = (int)(organic * perEmpty);
+        packed[k] = (uint32_t)(d | g << 8 | v << 16) | (uint32_t)o << 24;
+    }
+}
+
+// Тексели уровня level в прямоугольнике [tx0, tx1) x [ty0, ty1) из уровня level - 1
+static void BuildLodRect(SimSnapshot& snap, int level, int tx0, int tx1, int ty0, int ty1, bool sample) {
+    const int srcW = LodSide(snap.w, level - 1), srcH = LodSide(snap.h, level - 1);
+    const int dstW = LodSide(snap.w, level);
+    LodTexel* dst = snap.lods[level - 1].data();
+    const unsigned char* cells = snap.cells.data();
+    const LodTexel* src = level == 1 ? nullptr : snap.lods[level - 2].data();
+    for (int ty = ty0; ty < ty1; ty++) {
+        int tx = tx0;
+        if (level == 1 && !sample && 2 * ty + 1 < srcH) {
+            int full = std::max(std::min(tx1, srcW / 2) - tx0, 0);
+            const unsigned char* top = cells + 2 * ((size_t)(2 * ty) * srcW + 2 * tx0);
+            BuildLod1Row(top, top + 2 * srcW, full, dst + (size_t)ty * dstW + tx0);
+            tx += full;
+        }
+        for (; tx < tx1; tx++) {
+            const int sx = 2 * tx, sy = 2 * ty;
+            LodTexel& out = dst[(size_t)ty * dstW + tx];
+            // Внутри мира у текселя ровно 4 потомка - без проверок краёв
+            if (sx + 1 < srcW && sy + 1 < srcH) {
+                if (level == 1) {
+                    const unsigned char* top = cells + 2 * ((size_t)sy * srcW + sx);
+                    const unsigned char* quad[4] = { top, top + 2, top + 2 * srcW, top + 2 * srcW + 2 };
+                    out = CellsTexel(quad, 4, sample);
+                } else {
+                    const LodTexel* top = src + (size_t)sy * srcW + sx;
+                    const LodTexel quad[4] = { top[0], top[1], top[srcW], top[srcW + 1] };
+                    out = CombineTexels(quad, 4, sample);
+                }
+                continue;
+            }
+            const unsigned char* quadCells[4];
+            LodTexel quad[4];
+            int count = 0;
+            for (int y = sy; y < std::min(sy + 2, srcH); y++) {
+                for (int x = sx; x < std::min(sx + 2, srcW); x++) {
+                    if (level == 1) quadCells[count++] = cells + 2 * ((size_t)y * srcW + x);
+                    else quad[count++] = src[(size_t)y * srcW + x];
+                }
+            }
+            out = level == 1 ? CellsTexel(quadCells, count, sample) : CombineTexels(quad, count, sample);
+        }
+    }
+}
+
+// Изменившиеся тайлы - в блоки снимка. Тайл помечает и клетки на шаг за своим краем (движение, деление),
+// поэтому к его отрезку по каждой оси добавляются соседние клетки - по тору у противоположного края
+static void CollectViewDirty(int blocksX) {
+    static_assert(TILE_SIZE <= RENDER_BLOCK, "тайл задевает больше двух блоков снимка по оси");
+    auto blocks = [](int a0, int a1, int size, int* out) {
+        int n = 0;
+        out[n++] = (a0 + size - 1) % size / RENDER_BLOCK;
+        for (int b = a0 / RENDER_BLOCK; b <= (a1 - 1) / RENDER_BLOCK; b++) out[n++] = b;
+        out[n++] = a1 % size / RENDER_BLOCK;
+        return n;
+    };
+    for (Tile& tile : tiles) {
+        if (!tile.viewDirty) continue;
+        tile.viewDirty = false;
+        int xs[4], ys[4];
+        int nx = blocks(tile.x0, tile.x1, world.w, xs), ny = blocks(tile.y0, tile.y1, world.h, ys);
+        for (int j = 0; j < ny; j++) {
+            for (int i = 0; i < nx; i++) publishedDirty[(size_t)ys[j] * blocksX + xs[i]] = 1;
+        }
+    }
+}
+
+void BuildSnapshot(SimSnapshot& snap) {
+    ProfScope scope(PROF_SNAPSHOT);
+    const int W = world.w, H = world.h;
+    const int blocksX = (W + RENDER_BLOCK - 1) / RENDER_BLOCK;
+    const int blocksY = (H + RENDER_BLOCK - 1) / RENDER_BLOCK;
+    const unsigned seq = ++snapshotSeq;
+
+    // Новый размер мира или режим просмотра - в publishedCells ничего годного: собрать все блоки
+    bool resized = publishedCells.size() != (size_t)world.cells * 2;
+    if (resized) {
+        publishedCells.assign((size_t)world.cells * 2, 0);
+        publishedVersion.assign((size_t)blocksX * blocksY, seq);
+        publishedDirty.assign((size_t)blocksX * blocksY, 1);
+    }
+    const bool full = resized || publishedView != snapshotView;
+    publishedView = snapshotView;
+    CollectViewDirty(blocksX);
+    // Энергия и возраст ботов меняются каждый тик - в этих режимах грязен любой видимый блок
+    const bool everyTick = snapshotView == VIEW_ENERGY || snapshotView == VIEW_AGE;
+    // Видимые блоки [vbx0, vbx1] x [vby0, vby1], с запасом в блок
+    const SnapshotRect& rect = snapshotVisible;
+    const int cx0 = std::max(rect.x0, 0), cy0 = std::max(rect.y0, 0);
+    const int cx1 = std::min(rect.x1, W), cy1 = std::min(rect.y1, H);
+    const bool anyVisible = cx0 < cx1 && cy0 < cy1;
+    const int vbx0 = cx0 / RENDER_BLOCK - 1, vby0 = cy0 / RENDER_BLOCK - 1;
+    const int vbx1 = (cx1 - 1) / RENDER_BLOCK + 1, vby1 = (cy1 - 1) / RENDER_BLOCK + 1;
+
+    // LOD зависит от режима просмотра и при тех же байтах клеток; новые уровни слот ещё не видел
+    const int levels = std::min(LodLevelCount(W, H), snapshotLodLevels);
+    bool slotStale = snap.w != W || snap.h != H || snap.view != snapshotView || (int)snap.lods.size() != levels;
+    unsigned slotSeq = slotStale ? 0 : snap.seq; // Что уже лежит в слоте
+    snap.w = W;
+    snap.h = H;
+    snap.tick = worldTick;
+    snap.alive = aliveCount;
+    snap.cells.resize((size_t)world.cells * 2);
+    snap.seq = seq;
+    snap.view = snapshotView;
+    snap.blocksX = blocksX;
+    snap.blocksY = blocksY;
+    const bool sample = snapshotView == VIEW_GENOME; // Средний хеш генома ничего не значит
+    snap.lods.resize(levels);
+    for (int level = 1; level <= levels; level++) {
+        snap.lods[level - 1].resize((size_t)LodSide(W, level) * LodSide(H, level));
+    }
+
+    const WorldBuffer& grid = worldGrid;
+    const SnapshotView view = snapshotView;
+    unsigned char* published = publishedCells.data();
+    unsigned char* out = snap.cells.data();
+    // По строкам блоков: внутри строки память идёт подряд
+    workerPool.ParallelFor(0, blocksY, [&](int start, int end, int) {
+        std::vector<unsigned char> pack(blocksX); // Блок собирается из сетки на этом снимке
+        for (int by = start; by < end; by++) {
+            unsigned* version = publishedVersion.data() + (size_t)by * blocksX;
+            unsigned char* dirty = publishedDirty.data() + (size_t)by * blocksX;
+            const bool rowVisible = anyVisible && by >= vby0 && by <= vby1;
+            for (int bx = 0; bx < blocksX; bx++) {
+                const bool visible = rowVisible && bx >= vbx0 && bx <= vbx1;
+                pack[bx] = full || (visible && (dirty[bx] || everyTick));
+                if (!pack[bx]) continue;
+                dirty[bx] = 0;
+                version[bx] = seq;
+            }
+            int y1 = std::min((by + 1) * RENDER_BLOCK, H);
+            for (int y = by * RENDER_BLOCK; y < y1; y++) {
+                for (int bx = 0; bx < blocksX; bx++) {
+                    // Слот отстаёт от опубликованного только в блоках, менявшихся после его прошлого заполнения
+                    if (version[bx] <= slotSeq) continue;
+                    const int x0 = bx * RENDER_BLOCK, n = std::min(RENDER_BLOCK, W - x0);
+                    const int base = y * W + x0;
+                    unsigned char* row = published + 2 * (size_t)base;
+                    if (pack[bx]) {
+                        const unsigned char* alive = grid.alive.data() + base;
+                        const unsigned char* color = grid.color.data() + base;
+                        const int* organic = grid.organic.data() + base;
+                        for (int x = 0; x < n; x++) {
+                            // alive - 0/1, CELL_EMPTY - 0: без ветвления, чтобы цикл векторизовался
+                            row[2 * x] = (unsigned char)(alive[x] * (CELL_BOT + color[x]));
+                            row[2 * x + 1] = (unsigned char)std::min(std::max(organic[x], 0), 255);
+                        }
+                        if (view != VIEW_ORGANIC) {
+                            for (int x = 0; x < n; x++) {
+                                if (alive[x]) row[2 * x + 1] = ViewValue(view, grid, base + x);
+                            }
+                        }
+                    }
+                    std::memcpy(out + 2 * (size_t)base, row, (size_t)n * 2);
+                }
+            }
+            for (int bx = 0; bx < blocksX; bx++) {
+                if (version[bx] <= slotSeq) continue;
+                // Уровни, где тексель не крупнее блока, лежат внутри блока целиком
+                for (int level = 1; level <= std::min(levels, RENDER_BLOCK_SHIFT); level++) {
+                    int side = RENDER_BLOCK >> level;
+                    BuildLodRect(snap, level, bx * side, std::min((bx + 1) * side, LodSide(W, level)),
+                                 by * side, std::min((by + 1) * side, LodSide(H, level)), sample);
+                }
+            }
+        }
+    });
+    for (int level = RENDER_BLOCK_SHIFT + 1; level <= levels; level++) {
+        BuildLodRect(snap, level, 0, LodSide(W, level), 0, LodSide(H, level), sample);
+    }
+    snap.blockVersion = publishedVersion;
+}
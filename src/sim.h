@@ -0,0 +1,332 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rules.h"
+#include "thread_pool.h"
+#include "vm.h"
+
+// Ядро симуляции: состояние мира и тик. Не зависит от raylib, поэтому
+// собирается и в графическое приложение, и в headless-бенчмарк.
+
+// --- ПАРАМЕТРЫ МИРА ---
+// Задаются при запуске: аргументы командной строки / файл конфигурации на ПК, extras интента на Android
+struct SimConfig {
+    int worldW = 256; // 256 * 128 = 32,768 клеток (хватит для 10k ботов)
+    int worldH = 128;
+    int genomeSize = 64;
+    int threads = 0;  // 0 = hardware_concurrency
+    int vm = 0;       // VmMode: 0 - скалярная VM, 1 - SIMD, 2 - SIMD со сверкой
+    bool pinBigCores = false;
+    unsigned seed = 12345;
+    int tickRate = 60;      // Целевые тики/с в GUI (0 = без ограничения)
+    int ticksPerFrame = 0;  // > 0: ровно столько тиков на каждый кадр (перемотка)
+    int perf = -1;          // PerfMode (power.h) в GUI; -1 - DefaultPerfMode()
+    std::string stats;      // Файл ряда статистики по тикам (.csv или бинарный, см. stats.h); пусто - не писать
+    std::string replay;     // Каталог журнала прогона (replay.h); пусто - не писать
+    int replayInterval = 500; // Тиков между опорными кадрами журнала
+    int replayKeyframes = 8;  // Опорных кадров в памяти (остальные - только на диске)
+    SimRules rules;           // Числа экономики и топология (rules.h); в сохранение не пишутся
+    bool genericRules = false; // Общее ядро хода и для пресетов (сверка специализаций, замеры)
+};
+
+// Ограничения: ip - unsigned char, индексы клеток - int, в тайловой раскраске нужно >= 2 клеток по оси
+const int MIN_WORLD_SIDE = 2;
+const int MAX_WORLD_CELLS = 1 << 30;
+const int MIN_GENOME_SIZE = 8; // Не короче самого длинного перехода (0-7)
+const int MAX_GENOME_SIZE = 256;
+const int MAX_COMMAND_LIMIT = 1024;
+const int MAX_RULE_VALUE = 1 << 16; // Энергия и органика в правилах: без переполнения int за тик
+
+extern SimConfig config;
+
+bool ApplyConfigValue(SimConfig& cfg, const std::string& key, const std::string& value);
+bool LoadConfigFile(SimConfig& cfg, const char* path);
+void ParseArgs(SimConfig& cfg, int argc, char** argv);
+void ClampConfig(SimConfig& cfg);
+
+// Геометрия мира. Для размеров-степеней двойки координаты и тор считаются масками и сдвигами.
+struct WorldGeometry {
+    int w = 0, h = 0, cells = 0;
+    bool pow2 = false;
+    int shift = 0;  // log2(w)
+    int maskX = 0, maskY = 0;
+
+    void Set(int width, int height) {
+        w = width;
+        h = height;
+        cells = w * h;
+        pow2 = (w & (w - 1)) == 0 && (h & (h - 1)) == 0;
+        shift = 0;
+        while ((1 << shift) < w) shift++;
+        maskX = w - 1;
+        maskY = h - 1;
+    }
+
+    // Узел распределённого мира (distributed.h) считает полосу строк глобального мира вместе с гало:
+    // локальная клетка c - это глобальная (c + globalBase) mod globalCells. По глобальному номеру
+    // берутся случайные числа и разрешаются споры заявок - так узел повторяет одиночный прогон.
+    // В обычном мире globalBase = 0 и номер тот же.
+    long long globalBase = 0, globalCells = 0;
+    uint32_t GlobalCell(int cell) const {
+        long long g = cell + globalBase;
+        return (uint32_t)(g < globalCells ? g : g % globalCells); // Полоса выше мира (узел один) заходит на круг дважды
+    }
+
+    int X(int cell) const { return pow2 ? (cell & maskX) : (cell % w); }
+    int Y(int cell) const { return pow2 ? (cell >> shift) : (cell / w); }
+
+    // Соседняя клетка в тороидальном (зацикленном) мире
+    int Neighbor(int cell, int dx, int dy) const {
+        if (pow2) {
+            return (((Y(cell) + dy) & maskY) << shift) | ((X(cell) + dx) & maskX);
+        }
+        int nx = X(cell) + dx;
+        int ny = Y(cell) + dy;
+        if (nx < 0) nx += w; else if (nx >= w) nx -= w;
+        if (ny < 0) ny += h; else if (ny >= h) ny -= h;
+        return ny * w + nx;
+    }
+
+    // Соседняя клетка в мире с краями; -1 - за краем
+    int NeighborBounded(int cell, int dx, int dy) const {
+        int nx = X(cell) + dx;
+        int ny = Y(cell) + dy;
+        if ((unsigned)nx >= (unsigned)w || (unsigned)ny >= (unsigned)h) return -1;
+        return pow2 ? (ny << shift) | nx : ny * w + nx;
+    }
+};
+
+extern WorldGeometry world;
+
+// Какой кусок глобального мира выделит AllocateWorld: cells = 0 - весь мир (config.worldW x worldH)
+struct WorldPartition {
+    long long base = 0;  // Глобальный номер локальной клетки 0
+    long long cells = 0; // Клеток в глобальном мире
+};
+extern WorldPartition worldPartition;
+extern int genomeSize;
+
+// Смещения для 8 направлений
+const int DIR_X[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int DIR_Y[] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+// Цвет бота хранится индексом в палитре (1 байт вместо Color)
+enum BotColor : unsigned char {
+    BOT_COLOR_GREEN = 0, // Фотосинтез (и цвет по умолчанию)
+    BOT_COLOR_RED = 1,   // Поедание органики
+};
+// --- СОСТОЯНИЕ МИРА (SoA) ---
+// Каждое поле клетки лежит в своём плотном массиве: горячие сканы (alive, отрисовка)
+// трогают 1 байт на клетку, а не всю структуру бота.
+// Байтовые массивы длиннее сетки на SIMD_GATHER_PAD: SIMD-VM читает их 32-битными gather.
+const int SIMD_GATHER_PAD = 3;
+
+struct WorldBuffer {
+    std::vector<unsigned char> alive;   // 0/1 на клетку
+    std::vector<int> energy;
+    std::vector<int> organic;           // Органическое вещество (еда)
+    std::vector<unsigned char> ip;      // Instruction Pointer
+    std::vector<unsigned char> dir;     // 0-7 directions
+    std::vector<unsigned char> color;   // BotColor
+    std::vector<int> genome;            // Слот в genomePool
+    std::vector<unsigned> born;         // Тик рождения (только для режима просмотра "возраст")
+
+    void Resize(int cells) {
+        alive.assign(cells + SIMD_GATHER_PAD, 0);
+        energy.assign(cells, 0);
+        organic.assign(cells, 0);
+        ip.assign(cells + SIMD_GATHER_PAD, 0);
+        dir.assign(cells + SIMD_GATHER_PAD, 0);
+        color.assign(cells + SIMD_GATHER_PAD, BOT_COLOR_GREEN);
+        genome.assign(cells, -1);
+        born.assign(cells, 0);
+    }
+};
+
+// --- ПУЛ ГЕНОМОВ (ИНТЕРНИРОВАНИЕ) ---
+// Геномы живут отдельно от сетки и не двойные: бот хранит только индекс слота (32-битный handle).
+// Одинаковые геномы делят один неизменяемый слот: Intern находит его по 64-битному отпечатку
+// (с побайтовой проверкой) и считает ссылки. Рядом со слотом лежит его скомпилированный код
+// (см. vm.h) - он собирается один раз на уникальный геном.
+// Слот, на который не осталось ссылок, уходит в freeSlots и выпадает из индекса.
+// Все методы, меняющие пул, вызываются из одного потока (генерация, загрузка, фаза слияния тика).
+const int GENOME_SLAB = 1024;
+
+struct GenomePool {
+    std::vector<unsigned char> data; // genomeSize байт на слот
+    std::vector<VmStep> code;        // genomeSize шагов на слот
+    std::vector<unsigned char> hash; // 8-битный отпечаток генома слота (раскраска по геному)
+    std::vector<uint64_t> print;     // 64-битный отпечаток (ключ индекса)
+    std::vector<int> refs;           // Ботов на слоте; 0 - слот свободен
+    std::vector<unsigned char> sensesOrganic; // В коде слота есть VM_OP_SENSE_ORGANIC
+    int organicSensors = 0;          // Живых слотов с sensesOrganic: 0 - суммы органики никто не читает
+    std::vector<int> freeSlots;
+    std::unordered_multimap<uint64_t, int> index; // Отпечаток -> живые слоты
+
+    // Слот с таким содержимым (+1 ссылка): существующий или новый, уже скомпилированный
+    int Intern(const unsigned char* genome);
+    // Живой слот с отпечатком print, если он с таким отпечатком один, иначе -1; ссылок не добавляет.
+    // Байтов не сверить, поэтому при коллизии отпечатков нужны сами байты (Intern)
+    int Find(uint64_t print) const;
+    void Retain(int slot) { refs[slot]++; }
+    void Release(int slot) {
+        if (--refs[slot] == 0) Drop(slot);
+    }
+
+    int Slots() const { return (int)refs.size(); }
+    int Unique() const { return Slots() - (int)freeSlots.size(); } // Различных геномов в мире
+
+    // Пересобрать ссылки и индекс по боту на клетку (после записи сетки в обход тика)
+    void Recount(const std::vector<unsigned char>& alive, const std::vector<int>& genome, int cells);
+
+    const unsigned char* Get(int slot) const { return &data[(size_t)slot * genomeSize]; }
+    const VmStep* Code(int slot) const { return &code[(size_t)slot * genomeSize]; }
+
+    static uint64_t Fingerprint(const unsigned char* genome);
+
+private:
+    int Alloc();
+    void Drop(int slot);
+    void Compile(int slot);
+};
+
+// Сетка одна: тик применяет изменения на месте (см. намерения в sim.cpp)
+extern WorldBuffer worldGrid;
+extern GenomePool genomePool;
+
+// Статистика
+extern std::atomic<int> aliveCount; // popcount битборда занятости после тика; атомарный - его читает и поток GUI
+extern unsigned worldTick;
+
+// Пул воркеров живёт всё время работы программы (размер задаётся в main)
+extern ThreadPool workerPool;
+
+extern uint32_t worldSeed; // Ключ счётчикового ГСЧ (rng.h): вместе с worldTick - всё его состояние
+
+// Пустой мир по config: размеры, геномы, тайлы; worldTick = 1. InitWorld заселяет его случайно,
+// LoadWorld (save.h) - из файла
+void AllocateWorld();
+void InitWorld();
+void UpdateWorld();
+
+// Сетка изменена в обход тика (GPU-бэкенд, загрузка): заново собрать списки ботов тайлов,
+// свободные слоты геномов и aliveCount
+void RebuildBotLists();
+// В обход тика переписаны только строки [r0, r0 + rows) (гало распределённого мира): списки ботов,
+// занятость и органика индекса догоняют только их. Ссылки пула уже поправил писавший; aliveDelta и
+// organicDelta - на сколько в этих строках изменилось число живых и органика
+void RefreshRows(int r0, int rows, int aliveDelta, long long organicDelta);
+
+// Прирост органики в пустых клетках: +10 с вероятностью 1/1001 за тик.
+// Выпадение - CellRandom(OrganicKey(tick), cell) < ORGANIC_GROWTH_THRESHOLD (общее для CPU и GPU)
+const int ORGANIC_GROWTH = 10;
+const uint32_t ORGANIC_GROWTH_THRESHOLD = (uint32_t)(4294967296.0 / 1001.0);
+uint32_t OrganicKey(unsigned tick);
+
+// Диффузия и распад: на тиках, кратных ORGANIC_DIFFUSION_INTERVAL, отдельный проход-стенсил по всей сетке.
+// Клетка отдаёт каждому из 4 соседей c >> ORGANIC_DIFFUSE_SHIFT (масса сохраняется точно;
+// в мире с краями соседа за краем нет - эта доля остаётся в клетке),
+// затем от результата v распадается v >> ORGANIC_DECAY_SHIFT: мелкие остатки не гниют, кучи у трупов - да.
+// Пока только на CPU: GPU-бэкенд органику не размывает.
+const int ORGANIC_DIFFUSION_INTERVAL = 8;
+const int ORGANIC_DIFFUSE_SHIFT = 3;
+const int ORGANIC_DECAY_SHIFT = 6;
+
+// Контрольная сумма состояния мира (органика + боты, включая геномы).
+// Один seed должен давать одну и ту же сумму при любом числе потоков.
+uint64_t WorldChecksum();
+
+// Параметры прогона "ключ=значение" через пробел - шапка экспорта профайлера
+std::string RunDescription();
+
+// --- СНИМОК ДЛЯ ОТРИСОВКИ ---
+// Компактная копия того, что нужно рендеру: 2 байта на клетку [тип, органика].
+enum SnapshotCell : unsigned char {
+    CELL_EMPTY = 0,
+    CELL_BOT = 1, // CELL_BOT + BotColor
+};
+
+// Что лежит во втором байте клетки-бота. Пустые клетки всегда несут органику.
+// Меняется только в потоке симуляции (через SimThread::Post), как и остальной мир.
+enum SnapshotView : int {
+    VIEW_ORGANIC = 0, // Бот рисуется цветом BotColor (второй байт - органика под ним)
+    VIEW_ENERGY,      // min(energy >> VIEW_ENERGY_SHIFT, 255)
+    VIEW_GENOME,      // GenomePool::hash слота
+    VIEW_AGE,         // min((tick - born) >> VIEW_AGE_SHIFT, 255)
+    VIEW_COUNT
+};
+
+const int VIEW_ENERGY_SHIFT = 3;
+const int VIEW_AGE_SHIFT = 4;
+
+extern SnapshotView snapshotView;
+const char* ViewName(SnapshotView view);
+
+// Мир делится на блоки RENDER_BLOCK x RENDER_BLOCK. Версия блока - номер снимка, в котором
+// его последний раз собрали из изменившейся сетки; рендер перерисовывает и заливает в текстуру
+// только видимые блоки новее того, что уже нарисовал.
+const int RENDER_BLOCK = 64;
+const int RENDER_BLOCK_SHIFT = 6;
+
+// --- LOD ---
+// Уровень L >= 1 - тексели по 2^L x 2^L клеток, собранные из уровня L - 1.
+// Уровни 1..RENDER_BLOCK_SHIFT пересчитываются по блокам вместе с самим блоком,
+// более грубые (тексель больше блока) - целиком на каждом снимке: они крошечные.
+struct LodTexel {
+    unsigned char density; // Доля клеток с ботом (0-255)
+    unsigned char green;   // Доля BOT_COLOR_GREEN среди ботов - по ней выбирается преобладающий цвет
+    unsigned char value;   // Среднее значение view по ботам (в VIEW_GENOME - значение самого плотного потомка)
+    unsigned char organic; // Средняя органика по пустым клеткам
+};
+
+const int LOD_TOP_SIDE = 64; // Уровни строятся, пока большая сторона предыдущего уровня больше этого
+
+inline int LodSide(int side, int level) { return (side + (1 << level) - 1) >> level; }
+int LodLevelCount(int w, int h); // Без уровня 0
+
+// Сколько уровней строить: рендер просит столько, сколько нужно текущему зуму (0 - только клетки).
+// Как и snapshotView, меняется в потоке симуляции.
+extern int snapshotLodLevels;
+
+// Видимая рендером часть мира в клетках: [x0, x1) x [y0, y1). Снимок пакует только блоки внутри неё
+// (с запасом в блок на сдвиг камеры), изменившиеся блоки вне её ждут, пока попадут в кадр.
+// По умолчанию - весь мир. Как и snapshotView, меняется в потоке симуляции.
+struct SnapshotRect {
+    int x0 = 0, y0 = 0;
+    int x1 = 1 << 30, y1 = 1 << 30;
+};
+extern SnapshotRect snapshotVisible;
+
+struct SimSnapshot {
+    int w = 0, h = 0;
+    unsigned tick = 0;
+    int alive = 0;
+    SnapshotView view = VIEW_ORGANIC;
+    std::vector<unsigned char> cells; // cells[2*i] - SnapshotCell, cells[2*i+1] - органика или значение view (0-255)
+    unsigned seq = 0;                 // Номер снимка, начиная с 1 (0 - слот ещё не заполнялся)
+    int blocksX = 0, blocksY = 0;
+    std::vector<unsigned> blockVersion; // blocksX * blocksY, по строкам блоков
+    std::vector<std::vector<LodTexel>> lods; // lods[L - 1] - уровень L, LodSide(w, L) x LodSide(h, L)
+};
+
+// Заполняет снимок текущим состоянием мира (параллельно, через workerPool).
+// Пакуются только видимые блоки, в которых тик что-то поменял (Tile::viewDirty, sim.cpp);
+// в слот копируются блоки, изменившиеся после прошлого заполнения этого слота.
+void BuildSnapshot(SimSnapshot& snap);
+
+// Раскраска клеток [first, last) уровня 0 снимка по палитрам (CPU-путь DrawWorld).
+// Pixel - любой 4-байтный цвет: Color в main.cpp, свой тип в бенчмарке. bots == nullptr - режим VIEW_ORGANIC,
+// бот берёт цвет botColors[BotColor].
+template <class Pixel>
+inline void PackCellPixels(const unsigned char* cells, int first, int last, const Pixel* organic,
+                           const Pixel* bots, const Pixel* botColors, Pixel* pixels) {
+    for (int i = first; i < last; i++) {
+        unsigned char type = cells[2 * i], value = cells[2 * i + 1];
+        if (type == CELL_EMPTY) pixels[i] = organic[value];
+        else pixels[i] = bots ? bots[value] : botColors[type - CELL_BOT];
+    }
+}
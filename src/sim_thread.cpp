@@ -0,0 +1,128 @@
+#include "sim_thread.h"
+
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+void SimThread::Start(int tickRate, int ticksPerFrame) {
+    if (running_) return;
+    tickRate_ = tickRate;
+    ticksPerFrame_ = ticksPerFrame;
+    running_ = true;
+    snapshotWanted_ = true;
+    thread_ = std::thread([this] { Loop(); });
+}
+
+void SimThread::Stop() {
+    if (!running_) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void SimThread::Post(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands_.push_back(std::move(fn));
+    }
+    cv_.notify_all();
+}
+
+void SimThread::SetTickRate(int ticksPerSecond) {
+    tickRate_ = ticksPerSecond > 0 ? ticksPerSecond : 0;
+    cv_.notify_all();
+}
+
+void SimThread::SetTicksPerFrame(int ticks) {
+    ticksPerFrame_ = ticks > 0 ? ticks : 0;
+    cv_.notify_all();
+}
+
+void SimThread::SetPaused(bool paused) {
+    paused_ = paused;
+    cv_.notify_all();
+}
+
+void SimThread::FrameTick() {
+    snapshotWanted_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frameCounter_++;
+    }
+    cv_.notify_all();
+}
+
+void SimThread::RunCommands() {
+    std::vector<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending.swap(commands_);
+    }
+    for (auto& fn : pending) fn();
+}
+
+// Снимок строится только когда рендер его ждёт: не чаще одного раза за кадр
+void SimThread::PublishIfWanted() {
+    if (!snapshotWanted_.exchange(false)) return;
+    BuildSnapshot(snapshots_.Back());
+    snapshots_.Publish();
+}
+
+void SimThread::Loop() {
+    Clock::time_point nextTick = Clock::now();
+    Clock::time_point rateWindowStart = Clock::now();
+    unsigned lastFrame = frameCounter_;
+    long long rateWindowTicks = 0;
+
+    while (running_) {
+        RunCommands();
+        PublishIfWanted();
+
+        int ticks = 1;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto wakeUp = [&] { return !running_ || !commands_.empty() || snapshotWanted_; };
+            if (paused_) {
+                measuredRate_ = 0.0;
+                cv_.wait_for(lock, std::chrono::milliseconds(100), [&] { return wakeUp() || !paused_; });
+                nextTick = Clock::now();
+                continue;
+            }
+            if (ticksPerFrame_ > 0) {
+                // Перемотка: ждём очередной кадр и делаем за него ровно N тиков
+                cv_.wait(lock, [&] { return !running_ || !commands_.empty() || paused_ || ticksPerFrame_ == 0 ||
+                                            frameCounter_ != lastFrame; });
+                if (frameCounter_ == lastFrame) continue;
+                lastFrame = frameCounter_;
+                ticks = ticksPerFrame_;
+                nextTick = Clock::now();
+            } else if (tickRate_ > 0) {
+                // Снимок, который ждёт рендер, строится сразу, а не к следующему тику
+                if (cv_.wait_until(lock, nextTick, [&] { return !running_ || !commands_.empty() || paused_ ||
+                                                                ticksPerFrame_ > 0 || snapshotWanted_; })) {
+                    continue;
+                }
+                Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / tickRate_));
+                nextTick += period;
+                // Сильно отстали (медленный тик) - не пытаемся догонять пачкой
+                if (Clock::now() - nextTick > std::chrono::milliseconds(250)) nextTick = Clock::now();
+            } else {
+                nextTick = Clock::now();
+            }
+        }
+
+        for (int i = 0; i < ticks && running_; i++) UpdateWorld();
+        rateWindowTicks += ticks;
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - rateWindowStart).count();
+        if (elapsed >= 0.5) {
+            measuredRate_ = rateWindowTicks / elapsed;
+            rateWindowTicks = 0;
+            rateWindowStart = Clock::now();
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "sim.h"
+
+// --- ТРОЙНОЙ БУФЕР ---
+// Писатель всегда пишет в Back() и публикует его; читатель забирает самый свежий
+// опубликованный слот. Никто никого не ждёт: промежуточные снимки просто перезаписываются.
+template <class T>
+class TripleBuffer {
+public:
+    T& Back() { return slots_[back_]; }
+
+    void Publish() { back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask; }
+
+    // Самый свежий снимок, если он появился с прошлого вызова, иначе nullptr
+    const T* Acquire() {
+        if (!(middle_.load(std::memory_order_acquire) & kFresh)) return nullptr;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return &slots_[front_];
+    }
+
+    const T& Front() const { return slots_[front_]; }
+
+private:
+    static const int kFresh = 4;
+    static const int kIndexMask = 3;
+
+    T slots_[3];
+    int back_ = 0;
+    int front_ = 2;
+    std::atomic<int> middle_{1};
+};
+
+// --- ПОТОК СИМУЛЯЦИИ ---
+// Тики идут в своём потоке со своей частотой, рендер забирает последний готовый снимок.
+// Режимы: целевая частота (ticks/s), без ограничения (0) или ровно N тиков на кадр.
+// Всё, что трогает мир или workerPool, передаётся сюда через Post() и выполняется между тиками.
+class SimThread {
+public:
+    ~SimThread() { Stop(); }
+
+    void Start(int tickRate, int ticksPerFrame);
+    void Stop();
+
+    // Выполнить fn в потоке симуляции между тиками
+    void Post(std::function<void()> fn);
+
+    void SetTickRate(int ticksPerSecond);   // 0 = без ограничения
+    void SetTicksPerFrame(int ticks);       // 0 = выключено (работает частота)
+    void SetPaused(bool paused);
+
+    int TickRate() const { return tickRate_; }
+    int TicksPerFrame() const { return ticksPerFrame_; }
+    bool Paused() const { return paused_; }
+    bool Running() const { return running_; }
+    double MeasuredTicksPerSecond() const { return measuredRate_; }
+
+    // Вызывается рендером раз в кадр: просит свежий снимок и отмеряет кадр в режиме "N тиков на кадр"
+    void FrameTick();
+
+    // Новый снимок с прошлого вызова или nullptr
+    const SimSnapshot* AcquireSnapshot() { return snapshots_.Acquire(); }
+    // Последний забранный снимок (валиден до следующего AcquireSnapshot)
+    const SimSnapshot& LatestSnapshot() const { return snapshots_.Front(); }
+
+private:
+    void Loop();
+    void RunCommands();
+    void PublishIfWanted();
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::function<void()>> commands_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> paused_{false};
+    std::atomic<int> tickRate_{60};
+    std::atomic<int> ticksPerFrame_{0};
+    std::atomic<unsigned> frameCounter_{0};
+    std::atomic<bool> snapshotWanted_{true};
+    std::atomic<double> measuredRate_{0.0};
+
+    TripleBuffer<SimSnapshot> snapshots_;
+};
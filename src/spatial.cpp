@@ -0,0 +1,162 @@
+#include "spatial.h"
+
+#include <algorithm>
+#include "sim.h"
+#include "thread_pool.h"
+
+SpatialIndex spatialIndex;
+
+// Отрезок [c - r, c + r] на оси длины size -> до двух отрезков [a, b) внутри [0, size);
+// bounded - часть отрезка внутри оси, без переноса
+static int WrapSpan(int c, int r, int size, bool bounded, int* a, int* b) {
+    if (bounded) {
+        a[0] = std::max(c - r, 0);
+        b[0] = std::min(c + r + 1, size);
+        return 1;
+    }
+    if (2 * r + 1 >= size) {
+        a[0] = 0;
+        b[0] = size;
+        return 1;
+    }
+    int lo = c - r, hi = c + r + 1;
+    if (lo < 0) {
+        a[0] = lo + size; b[0] = size;
+        a[1] = 0; b[1] = hi;
+        return 2;
+    }
+    if (hi > size) {
+        a[0] = lo; b[0] = size;
+        a[1] = 0; b[1] = hi - size;
+        return 2;
+    }
+    a[0] = lo;
+    b[0] = hi;
+    return 1;
+}
+
+uint32_t SpatialIndex::CountBits(size_t begin, size_t end) const {
+    if (begin >= end) return 0;
+    const size_t first = begin >> 6, last = (end - 1) >> 6;
+    const uint64_t headMask = ~0ull << (begin & 63);
+    const uint64_t tailMask = ~0ull >> (63 - ((end - 1) & 63));
+    if (first == last) return (uint32_t)__builtin_popcountll(occupancy_[first] & headMask & tailMask);
+    uint32_t n = (uint32_t)__builtin_popcountll(occupancy_[first] & headMask);
+    for (size_t i = first + 1; i < last; i++) n += (uint32_t)__builtin_popcountll(occupancy_[i]);
+    return n + (uint32_t)__builtin_popcountll(occupancy_[last] & tailMask);
+}
+
+// Строки окна подряд лежат в битборде со сдвигом w: каждая - один отрезок бит (или два у края тора)
+uint32_t SpatialIndex::BotsAround(int x, int y, int r) const {
+    int xa[2], xb[2], ya[2], yb[2];
+    int nx = WrapSpan(x, r, w_, bounded_, xa, xb);
+    int ny = WrapSpan(y, r, h_, bounded_, ya, yb);
+    uint32_t sum = 0;
+    for (int j = 0; j < ny; j++) {
+        for (int row = ya[j]; row < yb[j]; row++) {
+            const size_t base = (size_t)row * w_;
+            for (int i = 0; i < nx; i++) sum += CountBits(base + xa[i], base + xb[i]);
+        }
+    }
+    return sum;
+}
+
+// Прямоугольник без переноса режется по границам блоков (у окна 3x3 - не больше 2 x 2 кусков)
+uint32_t SpatialIndex::Rect(int x0, int y0, int x1, int y1) const {
+    uint32_t sum = 0;
+    for (int by = y0 / blockH_; by < blocksY_ && by * blockH_ < y1; by++) {
+        for (int bx = x0 / blockW_; bx < blocksX_ && bx * blockW_ < x1; bx++) {
+            const Block& b = blocks_[by * blocksX_ + bx];
+            sum += Box(b, std::max(x0, b.x0), std::max(y0, b.y0), std::min(x1, b.x0 + b.w), std::min(y1, b.y0 + b.h));
+        }
+    }
+    return sum;
+}
+
+uint32_t SpatialIndex::OrganicAround(int x, int y, int r) const {
+    int xa[2], xb[2], ya[2], yb[2];
+    int nx = WrapSpan(x, r, w_, bounded_, xa, xb);
+    int ny = WrapSpan(y, r, h_, bounded_, ya, yb);
+    uint32_t sum = 0;
+    for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) sum += Rect(xa[i], ya[j], xb[i], yb[j]);
+    }
+    return sum;
+}
+
+// Таблица блока: префиксы по строкам с накоплением по столбцам, строки подряд (векторизуется)
+void SpatialIndex::BuildBlock(const WorldBuffer& grid, const Block& b) {
+    const size_t stride = (size_t)b.w + 1;
+    uint32_t* s = &organic_[b.offset];
+    std::fill(s, s + stride, 0u);
+    for (int y = 0; y < b.h; y++) {
+        const int* organic = &grid.organic[(size_t)(b.y0 + y) * w_ + b.x0];
+        const uint32_t* prev = s + y * stride;
+        uint32_t* row = s + (y + 1) * stride;
+        uint32_t sum = 0;
+        row[0] = 0;
+        for (int x = 0; x < b.w; x++) {
+            sum += (uint32_t)organic[x];
+            row[x + 1] = prev[x + 1] + sum;
+        }
+    }
+}
+
+int SpatialIndex::RefreshOrganic(const WorldBuffer& grid, ThreadPool& pool) {
+    dirtyList_.clear();
+    for (int i = 0; i < (int)dirty_.size(); i++) {
+        if (dirty_[i]) dirtyList_.push_back(i);
+    }
+    pool.ForEachTask((int)dirtyList_.size(), [&](int i, int) {
+        const int block = dirtyList_[i];
+        BuildBlock(grid, blocks_[block]);
+        dirty_[block] = 0;
+    });
+    return (int)dirtyList_.size();
+}
+
+// Битборд - параллельно по словам, таблицы органики - по блокам
+void SpatialIndex::Rebuild(const WorldBuffer& grid, int w, int h, int blockW, int blockH, bool bounded, ThreadPool& pool) {
+    w_ = w;
+    h_ = h;
+    bounded_ = bounded;
+    const int cells = w * h;
+    const int words = (cells + 63) / 64;
+    occupancy_.resize(words);
+    workerAlive_.assign(pool.Size(), 0);
+    pool.ParallelFor(0, words, [&](int w0, int w1, int worker) {
+        int alive = 0;
+        for (int i = w0; i < w1; i++) {
+            const unsigned char* src = &grid.alive[(size_t)i * 64];
+            const int n = std::min(64, cells - i * 64);
+            uint64_t bits = 0;
+            for (int b = 0; b < n; b++) bits |= (uint64_t)(src[b] & 1) << b;
+            occupancy_[i] = bits;
+            alive += __builtin_popcountll(bits);
+        }
+        workerAlive_[worker] = alive;
+    });
+    alive_ = 0;
+    for (int n : workerAlive_) alive_ += n;
+
+    blockW_ = std::max(1, std::min(blockW, w));
+    blockH_ = std::max(1, std::min(blockH, h));
+    blocksX_ = (w + blockW_ - 1) / blockW_;
+    blocksY_ = (h + blockH_ - 1) / blockH_;
+    blocks_.resize((size_t)blocksX_ * blocksY_);
+    size_t offset = 0;
+    for (int by = 0; by < blocksY_; by++) {
+        for (int bx = 0; bx < blocksX_; bx++) {
+            Block& b = blocks_[by * blocksX_ + bx];
+            b.x0 = bx * blockW_;
+            b.y0 = by * blockH_;
+            b.w = std::min(blockW_, w - b.x0);
+            b.h = std::min(blockH_, h - b.y0);
+            b.offset = offset;
+            offset += (size_t)(b.w + 1) * (b.h + 1);
+        }
+    }
+    organic_.resize(offset);
+    dirty_.assign(blocks_.size(), 0);
+    pool.ForEachTask((int)blocks_.size(), [&](int i, int) { BuildBlock(grid, blocks_[i]); });
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- ПРОСТРАНСТВЕННЫЕ ЗАПРОСЫ ---
+// Занятость - битборд: бит на клетку, 64 клетки подряд (по индексу клетки) в слове.
+// Проверка клетки - сдвиг слова, число ботов на отрезке строки - popcount по словам
+// с масками краёв.
+// Органика - таблицы сумм по прямоугольникам (summed-area), своя на каждый блок сетки:
+// S[y][x] - сумма по клеткам блока [0, x) x [0, y), таблица (bw + 1) x (bh + 1), сумма по
+// прямоугольнику внутри блока - 4 чтения; окно запроса режется по границам блоков.
+// Арифметика по модулю 2^32: промежуточные суммы переполняются, но разность
+// для прямоугольника точна, пока сама сумма в нём меньше 2^32.
+// Окно, пересекающее край тора, режется на куски (до 2 по каждой оси); в мире с краями - обрезается.
+//
+// Индекс не пересобирается каждый тик, а ведётся вместе с миром. Блоки - это тайлы тика (sim.cpp):
+//   - биты занятости ставит и снимает фаза 2 (SetOccupied / ClearOccupied) в момент записи alive;
+//   - органику тайл помечает (MarkOrganic), когда её меняет: рост, еда, труп. После тика
+//     RefreshOrganic пересчитывает таблицы только помеченных блоков - и только если хоть один
+//     живой геном вообще спрашивает органику (GenomePool::organicSensors); иначе пометки копятся.
+// Полная сборка (Rebuild) - после InitWorld / RebuildBotLists. В фазе 1 индекс совпадает с сеткой
+// и только читается.
+struct WorldBuffer;
+class ThreadPool;
+
+class SpatialIndex {
+public:
+    // Блоки blockW x blockH по сетке (последний в ряду может быть меньше), как тайлы тика
+    void Rebuild(const WorldBuffer& grid, int w, int h, int blockW, int blockH, bool bounded, ThreadPool& pool);
+
+    bool Occupied(int cell) const { return (occupancy_[cell >> 6] >> (cell & 63)) & 1; }
+    int Alive() const { return alive_; } // Живых на момент Rebuild
+
+    // Фаза 2: слово битборда делят соседние тайлы, поэтому запись атомарная
+    void SetOccupied(int cell) { __atomic_fetch_or(&occupancy_[cell >> 6], 1ull << (cell & 63), __ATOMIC_RELAXED); }
+    void ClearOccupied(int cell) { __atomic_fetch_and(&occupancy_[cell >> 6], ~(1ull << (cell & 63)), __ATOMIC_RELAXED); }
+
+    // Органика блока изменилась; блок пишет только задача своего тайла
+    void MarkOrganic(int block) { dirty_[block] = 1; }
+    void MarkAllOrganic() { std::fill(dirty_.begin(), dirty_.end(), (unsigned char)1); }
+    // Пересчитать таблицы помеченных блоков; возвращает, сколько их было
+    int RefreshOrganic(const WorldBuffer& grid, ThreadPool& pool);
+
+    // Квадрат (2r + 1) x (2r + 1) с центром в (x, y), по тору (или его часть внутри мира с краями)
+    uint32_t BotsAround(int x, int y, int r) const;
+    uint32_t OrganicAround(int x, int y, int r) const;
+
+private:
+    struct Block {
+        int x0, y0, w, h;
+        size_t offset; // Начало таблицы блока в organic_
+    };
+
+    // Занятые клетки с индексами [begin, end)
+    uint32_t CountBits(size_t begin, size_t end) const;
+    // Прямоугольник [x0, x1) x [y0, y1) внутри одного блока, в координатах мира
+    uint32_t Box(const Block& b, int x0, int y0, int x1, int y1) const {
+        const size_t stride = (size_t)b.w + 1;
+        const uint32_t* s = &organic_[b.offset];
+        x0 -= b.x0; x1 -= b.x0; y0 -= b.y0; y1 -= b.y0;
+        return s[y1 * stride + x1] - s[y0 * stride + x1] - s[y1 * stride + x0] + s[y0 * stride + x0];
+    }
+    // Прямоугольник мира без переноса: по всем блокам, которые он задевает
+    uint32_t Rect(int x0, int y0, int x1, int y1) const;
+    void BuildBlock(const WorldBuffer& grid, const Block& b);
+
+    int w_ = 0, h_ = 0;
+    bool bounded_ = false;
+    int alive_ = 0;
+    int blockW_ = 1, blockH_ = 1, blocksX_ = 1, blocksY_ = 1;
+    std::vector<uint64_t> occupancy_; // Хвост последнего слова нулевой
+    std::vector<Block> blocks_;
+    std::vector<uint32_t> organic_;
+    std::vector<unsigned char> dirty_;
+    std::vector<int> dirtyList_;
+    std::vector<int> workerAlive_;
+};
+
+extern SpatialIndex spatialIndex;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// --- ОЧЕРЕДЬ ОДИН ПИСАТЕЛЬ / ОДИН ЧИТАТЕЛЬ ---
+// Кольцо фиксированного размера (степень двойки) без блокировок: писатель двигает только head,
+// читатель - только tail. Полная очередь не ждёт читателя - TryPush возвращает false.
+template <class T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity = 1024) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        items_.resize(n);
+        mask_ = n - 1;
+    }
+
+    // Только из потока писателя
+    bool TryPush(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) return false;
+        items_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только из потока читателя
+    bool TryPop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        item = items_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> items_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0}; // Концы на разных кэш-линиях: писатель и читатель не делят линию
+    alignas(64) std::atomic<size_t> tail_{0};
+};
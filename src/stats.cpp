@@ -0,0 +1,67 @@
+#include "stats.h"
+
+#include <chrono>
+#include <cstring>
+
+TickStats tickStats = {};
+StatsRecorder* statsRecorder = nullptr;
+
+bool StatsRecorder::Open(const char* path) {
+    Close();
+    size_t len = std::strlen(path);
+    csv_ = len >= 4 && std::strcmp(path + len - 4, ".csv") == 0;
+    file_ = std::fopen(path, csv_ ? "w" : "wb");
+    if (!file_) return false;
+    path_ = path;
+    dropped_ = 0;
+    if (csv_) {
+        std::fprintf(file_, "tick,alive,births,deaths,mean_energy,organic,photosynthesis,predation,scavenging,moves,genomes\n");
+    } else {
+        uint32_t recordBytes = sizeof(TickStats);
+        std::fwrite(STATS_MAGIC, 1, sizeof(STATS_MAGIC), file_);
+        std::fwrite(&recordBytes, sizeof(recordBytes), 1, file_);
+    }
+    running_ = true;
+    thread_ = std::thread(&StatsRecorder::Loop, this);
+    return true;
+}
+
+void StatsRecorder::Close() {
+    if (!file_) return;
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void StatsRecorder::Push(const TickStats& stats) {
+    if (!queue_.TryPush(stats)) dropped_++;
+}
+
+void StatsRecorder::Write(const TickStats& s) {
+    if (csv_) {
+        std::fprintf(file_, "%u,%d,%d,%d,%.2f,%lld,%d,%d,%d,%d,%d\n", s.tick, s.alive, s.births, s.deaths,
+                     s.alive > 0 ? (double)s.energy / s.alive : 0.0, (long long)s.organic,
+                     s.photosynthesis, s.predation, s.scavenging, s.moves, s.genomes);
+    } else {
+        std::fwrite(&s, sizeof(s), 1, file_);
+    }
+}
+
+// Пустая очередь - короткий сон: писатель не должен будить поток симуляции
+void StatsRecorder::Loop() {
+    TickStats stats;
+    for (;;) {
+        bool stopping = !running_;
+        bool any = false;
+        while (queue_.TryPop(stats)) {
+            Write(stats);
+            any = true;
+        }
+        if (stopping) break;
+        if (!any) {
+            std::fflush(file_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
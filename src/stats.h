@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "spsc_queue.h"
+
+// --- СТАТИСТИКА ПОПУЛЯЦИИ ---
+// Счётчики ведёт каждый тайл в своих фазах тика (без общих атомиков), сводятся они
+// один раз за тик в фазе слияния. Итог тика лежит в tickStats и, если запись включена,
+// уходит через очередь в поток записи - тик никогда не ждёт диск.
+struct TickStats {
+    uint32_t tick;          // Номер только что посчитанного тика
+    int32_t alive;
+    int32_t births;         // Потомки (деление)
+    int32_t deaths;         // От голода + съеденные
+    int32_t photosynthesis; // Ходы, закончившиеся фотосинтезом
+    int32_t predation;      // Удачные атаки
+    int32_t scavenging;     // Поедание органики (что-то было съедено)
+    int32_t moves;          // Удачные перемещения
+    int32_t genomes;        // Различных геномов у живых ботов (GenomePool::Unique)
+    int32_t unused;
+    int64_t energy;         // Суммарная энергия ботов
+    int64_t organic;        // Суммарная органика мира
+};
+
+extern TickStats tickStats; // Последний тик (поток симуляции)
+
+// --- ЗАПИСЬ РЯДА ---
+// .csv - текст с заголовком, иначе бинарно: STATS_MAGIC, uint32 sizeof(TickStats), затем записи подряд.
+// Push зовётся из потока симуляции, писатель сам выбирает записи из очереди.
+const char STATS_MAGIC[8] = { 'A', 'L', 'I', 'F', 'E', 'S', 'T', '1' };
+
+class StatsRecorder {
+public:
+    ~StatsRecorder() { Close(); }
+
+    bool Open(const char* path);
+    void Close(); // Дописывает очередь и закрывает файл
+    bool IsOpen() const { return file_ != nullptr; }
+
+    // Переполненная очередь не тормозит тик: запись теряется и учитывается в Dropped
+    void Push(const TickStats& stats);
+    long long Dropped() const { return dropped_; }
+    const std::string& Path() const { return path_; }
+
+private:
+    void Loop();
+    void Write(const TickStats& stats);
+
+    SpscQueue<TickStats> queue_{4096};
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<long long> dropped_{0};
+    FILE* file_ = nullptr;
+    bool csv_ = false;
+    std::string path_;
+};
+
+// Куда UpdateWorld отдаёт итог тика (nullptr - запись выключена). Задаётся до старта потока симуляции.
+extern StatsRecorder* statsRecorder;
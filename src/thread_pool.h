@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sched.h>
+#define ALIFE_HAS_AFFINITY 1
+#endif
+
+// --- ПУЛ ПОТОКОВ ---
+// Долгоживущие воркеры, которые спят между тиками и просыпаются по счётчику поколений.
+// Вызывающий поток сам работает как воркер 0, поэтому Size() потоков = Size()-1 фоновых + caller.
+// Run() не аллоцирует: задача передаётся как указатель на функцию + контекст.
+class ThreadPool {
+public:
+    explicit ThreadPool(int workers = 0, bool pinBigCores = false) {
+        pinBigCores_ = pinBigCores;
+        Resize(workers);
+    }
+
+    ~ThreadPool() { Stop(); }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static int DefaultWorkers() {
+        int n = (int)std::thread::hardware_concurrency();
+        return n > 0 ? n : 4;
+    }
+
+    int Size() const { return size_; }
+    bool PinBigCores() const { return pinBigCores_; }
+
+    // Меняет число воркеров (0 = hardware_concurrency). Вызывать только между Run().
+    void Resize(int workers) {
+        if (workers <= 0) workers = DefaultWorkers();
+        if (workers == size_) return;
+        Stop();
+        size_ = workers;
+        busy_.assign(size_, BusySlot());
+        ranges_ = std::vector<StealRange>(size_);
+        wallNs_ = 0;
+        Spawn();
+    }
+
+    // Прикрепление фоновых воркеров к "большим" ядрам (big.LITTLE). Пересоздаёт потоки.
+    void SetPinBigCores(bool pin) {
+        if (pin == pinBigCores_) return;
+        pinBigCores_ = pin;
+        Stop();
+        Spawn();
+    }
+
+    // Выполнить fn(worker) на каждом воркере и дождаться завершения всех
+    template <class F>
+    void Run(F&& fn) {
+        using Fn = typename std::remove_reference<F>::type;
+        Dispatch([](void* ctx, int worker) { (*static_cast<Fn*>(ctx))(worker); }, &fn);
+    }
+
+    // Разбить [begin, end) на Size() равных кусков: fn(start, end, worker)
+    template <class F>
+    void ParallelFor(int begin, int end, F&& fn) {
+        int total = end - begin;
+        if (total <= 0) return;
+        int parts = std::min(size_, total);
+        int chunk = total / parts;
+        Run([&](int worker) {
+            if (worker >= parts) return;
+            int start = begin + worker * chunk;
+            int stop = (worker == parts - 1) ? end : (start + chunk);
+            fn(start, stop, worker);
+        });
+    }
+
+    // Задачи 0..count-1 с кражей работы: fn(task, worker).
+    // Воркер начинает со своего непрерывного куска [k * count / Size(), (k + 1) * count / Size()) -
+    // из тика в тик одни и те же задачи (тайлы) попадают на один воркер, и соседние задачи идут подряд.
+    // Свою очередь воркер берёт с начала; опустев, забирает заднюю половину остатка у самого
+    // загруженного воркера. Очередь - диапазон [begin, end) в одном 64-битном атомике, так что
+    // и взятие, и кража - один CAS, без блокировок и аллокаций.
+    template <class F>
+    void ForEachTask(int count, F&& fn) {
+        if (count <= 0) return;
+        for (int k = 0; k < size_; k++) {
+            ranges_[k].packed.store(PackRange((int)((int64_t)count * k / size_), (int)((int64_t)count * (k + 1) / size_)),
+                                    std::memory_order_relaxed);
+        }
+        Run([&](int worker) {
+            StealRange& own = ranges_[worker];
+            for (;;) {
+                int task;
+                while ((task = PopFront(own)) >= 0) fn(task, worker);
+                task = Steal(worker);
+                if (task < 0) break; // Все очереди пусты: новых задач не бывает, только деление старых
+                fn(task, worker);
+            }
+        });
+    }
+
+    // Загрузка воркеров с прошлого вызова: busy[w] = доля времени внутри Run(),
+    // которую воркер w работал (остальное - простой в ожидании самого медленного).
+    // Вызывать из того же потока, что и Run().
+    void TakeBusyStats(std::vector<double>& busy) {
+        busy.resize(size_);
+        for (int i = 0; i < size_; i++) {
+            busy[i] = wallNs_ > 0 ? (double)busy_[i].ns / wallNs_ : 0.0;
+            busy_[i].ns = 0;
+        }
+        wallNs_ = 0;
+    }
+
+private:
+    typedef void (*JobFn)(void*, int);
+    typedef std::chrono::steady_clock Clock;
+
+    static uint64_t NowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    // Каждый воркер пишет только свой слот; выравнивание убирает false sharing
+    struct alignas(64) BusySlot {
+        uint64_t ns = 0;
+    };
+
+    // Очередь задач воркера: begin в старших 32 битах, end - в младших
+    struct alignas(64) StealRange {
+        std::atomic<uint64_t> packed{0};
+    };
+
+    static uint64_t PackRange(int begin, int end) { return (uint64_t)(uint32_t)begin << 32 | (uint32_t)end; }
+    static int RangeBegin(uint64_t r) { return (int)(r >> 32); }
+    static int RangeEnd(uint64_t r) { return (int)(uint32_t)r; }
+
+    static int PopFront(StealRange& range) {
+        uint64_t r = range.packed.load(std::memory_order_relaxed);
+        for (;;) {
+            int begin = RangeBegin(r), end = RangeEnd(r);
+            if (begin >= end) return -1;
+            if (range.packed.compare_exchange_weak(r, PackRange(begin + 1, end), std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed)) {
+                return begin;
+            }
+        }
+    }
+
+    // Задняя половина самой длинной чужой очереди: первая задача - сразу на выполнение, остальное - в свою
+    // (она пуста, и в неё никто не пишет, кроме воров, которые пустую не трогают)
+    int Steal(int thief) {
+        for (;;) {
+            int victim = -1, most = 0;
+            uint64_t seen = 0;
+            for (int k = 0; k < size_; k++) {
+                if (k == thief) continue;
+                uint64_t r = ranges_[k].packed.load(std::memory_order_acquire);
+                int left = RangeEnd(r) - RangeBegin(r);
+                if (left > most) {
+                    most = left;
+                    victim = k;
+                    seen = r;
+                }
+            }
+            if (victim < 0) return -1;
+            int begin = RangeBegin(seen), end = RangeEnd(seen);
+            int mid = begin + most / 2;
+            if (!ranges_[victim].packed.compare_exchange_strong(seen, PackRange(begin, mid), std::memory_order_acq_rel,
+                                                                std::memory_order_relaxed)) {
+                continue; // Жертва успела взять задачу или её обокрали - выбираем заново
+            }
+            ranges_[thief].packed.store(PackRange(mid + 1, end), std::memory_order_release);
+            return mid;
+        }
+    }
+
+    void RunTimed(JobFn fn, void* ctx, int worker) {
+        uint64_t start = NowNs();
+        fn(ctx, worker);
+        busy_[worker].ns += NowNs() - start;
+    }
+
+    void Dispatch(JobFn fn, void* ctx) {
+        uint64_t start = NowNs();
+        DispatchAndWait(fn, ctx);
+        wallNs_ += NowNs() - start;
+    }
+
+    void DispatchAndWait(JobFn fn, void* ctx) {
+        if (size_ == 1) {
+            RunTimed(fn, ctx, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobFn_ = fn;
+            jobCtx_ = ctx;
+            pending_.store(size_ - 1, std::memory_order_relaxed);
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+        wakeCv_.notify_all();
+
+        RunTimed(fn, ctx, 0);
+
+        // Сначала короткий спин: на 60 тиках/с воркеры обычно заканчивают почти одновременно
+        for (int spin = 0; spin < kSpinIterations; spin++) {
+            if (pending_.load(std::memory_order_acquire) == 0) return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    // seen берётся в момент создания потока, иначе воркер, стартовавший позже Dispatch(), пропустит задачу
+    void WorkerLoop(int index, unsigned seen) {
+        if (pinBigCores_) PinToBigCore(index);
+
+        for (;;) {
+            bool woke = false;
+            for (int spin = 0; spin < kSpinIterations; spin++) {
+                if (generation_.load(std::memory_order_acquire) != seen || stopping_.load()) {
+                    woke = true;
+                    break;
+                }
+                std::this_thread::yield();
+            }
+            JobFn fn;
+            void* ctx;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!woke) {
+                    wakeCv_.wait(lock, [&] { return generation_.load() != seen || stopping_.load(); });
+                }
+                if (stopping_.load()) return;
+                seen = generation_.load();
+                fn = jobFn_;
+                ctx = jobCtx_;
+            }
+
+            RunTimed(fn, ctx, index);
+
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                doneCv_.notify_one();
+            }
+        }
+    }
+
+    void Spawn() {
+        stopping_ = false;
+        threads_.reserve(size_ - 1);
+        unsigned generation = generation_.load();
+        for (int i = 1; i < size_; i++) {
+            threads_.emplace_back([this, i, generation] { WorkerLoop(i, generation); });
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeCv_.notify_all();
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+    }
+
+    // Большие ядра = ядра с максимальной cpuinfo_max_freq. Если sysfs недоступен — не пиним.
+    static std::vector<int> BigCores() {
+        std::vector<int> cores;
+        std::vector<long> freqs;
+        int cpuCount = (int)std::thread::hardware_concurrency();
+        long best = 0;
+        for (int cpu = 0; cpu < cpuCount; cpu++) {
+            char path[96];
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+            long freq = 0;
+            if (FILE* f = std::fopen(path, "r")) {
+                if (std::fscanf(f, "%ld", &freq) != 1) freq = 0;
+                std::fclose(f);
+            }
+            freqs.push_back(freq);
+            best = std::max(best, freq);
+        }
+        if (best == 0) return cores;
+        for (int cpu = 0; cpu < cpuCount; cpu++) {
+            if (freqs[cpu] == best) cores.push_back(cpu);
+        }
+        return cores;
+    }
+
+    static void PinToBigCore(int index) {
+#ifdef ALIFE_HAS_AFFINITY
+        static const std::vector<int> bigCores = BigCores();
+        if (bigCores.empty()) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(bigCores[(index - 1) % bigCores.size()], &set);
+        sched_setaffinity(0, sizeof(set), &set); // 0 = текущий поток
+#else
+        (void)index;
+#endif
+    }
+
+    static const int kSpinIterations = 256;
+
+    int size_ = 0;
+    bool pinBigCores_ = false;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable doneCv_;
+    std::atomic<unsigned> generation_{0};
+    std::atomic<int> pending_{0};
+    std::atomic<bool> stopping_{false};
+    JobFn jobFn_ = nullptr;
+    void* jobCtx_ = nullptr;
+
+    std::vector<BusySlot> busy_;
+    std::vector<StealRange> ranges_; // Очереди ForEachTask, по одной на воркер
+    uint64_t wallNs_ = 0; // Суммарное время внутри Dispatch() с прошлого TakeBusyStats()
+};
@@ -0,0 +1,478 @@
+#include "vm.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include "sim.h"
+#include "spatial.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ALIFE_VM_AVX2 1
+#endif
+
+VmMode vmMode = VM_MODE_SCALAR;
+SimRules simRules;
+std::atomic<long long> vmCheckMismatches{0};
+
+// Прогон пошагового интерпретатора от каждого ip: стоит commandLimit * size,
+// но делается один раз при появлении генома, а не каждый тик для каждого бота
+void CompileGenome(const unsigned char* genome, int size, VmStep* out) {
+    const int limit = simRules.commandLimit;
+    for (int start = 0; start < size; start++) {
+        int ip = start;
+        int turn = 0;
+        unsigned char op = VM_OP_NONE;
+
+        for (int executed = 0; executed < limit && op == VM_OP_NONE; executed++) {
+            unsigned char cmd = genome[ip];
+            ip = (ip + 1) % size; // Сдвиг указателя
+
+            if (cmd < CMD_JUMP_END) ip = (ip + cmd) % size;
+            else if (cmd >= CMD_TURN_FIRST && cmd <= CMD_TURN_LAST) turn += cmd - CMD_TURN_FIRST;
+            else if (cmd == CMD_PHOTOSYNTHESIS) op = VM_OP_PHOTOSYNTHESIS;
+            else if (cmd == CMD_EAT) op = VM_OP_EAT;
+            else if (cmd == CMD_MOVE) op = VM_OP_MOVE;
+            else if (cmd == CMD_DIVIDE) op = VM_OP_DIVIDE;
+            else if (cmd == CMD_SENSE_CROWD) op = VM_OP_SENSE_CROWD;
+            else if (cmd == CMD_SENSE_ORGANIC) op = VM_OP_SENSE_ORGANIC;
+            else if (cmd == CMD_SENSE_ENERGY) op = VM_OP_SENSE_ENERGY;
+        }
+
+        out[start].op = op;
+        out[start].turn = (unsigned char)(turn % 8);
+        out[start].next = (unsigned char)ip;
+        out[start].alt = (unsigned char)((ip + genome[ip]) % size);
+    }
+}
+
+// --- ВИРТУАЛЬНАЯ МАШИНА (ЛОГИКА БОТА) ---
+// Весь поток управления хода разобран при компиляции генома (vm.h): остаётся взять шаг
+// из таблицы и выполнить его завершающую операцию через таблицу функций - один косвенный
+// переход на бота вместо цепочки сравнений на каждую команду.
+// Всё исполнение - шаблоны по типу правил R (rules.h): по ядру на пресет и на общий случай.
+template <class R>
+using VmOpFn = void (*)(const R& rules, int idx, const WorldBuffer& readGrid, BotIntent& out);
+
+// Клетка перед ботом: в мире с краями за краем её нет (-1)
+template <class R>
+static inline int Facing(int idx, int dir) {
+    return R::bounded ? world.NeighborBounded(idx, DIR_X[dir], DIR_Y[dir]) : world.Neighbor(idx, DIR_X[dir], DIR_Y[dir]);
+}
+
+template <class R>
+static void OpNone(const R&, int, const WorldBuffer&, BotIntent&) {}
+
+template <class R>
+static void OpPhotosynthesis(const R& rules, int, const WorldBuffer&, BotIntent& out) {
+    out.energy += rules.photosynthesis; // Получаем энергию от солнца
+    out.color = BOT_COLOR_GREEN; // Зеленеем
+}
+
+// Поедание органики под собой
+template <class R>
+static void OpEat(const R& rules, int idx, const WorldBuffer& readGrid, BotIntent& out) {
+    if (readGrid.organic[idx] > 0) {
+        int eat = std::min(readGrid.organic[idx], (int)rules.eatCap);
+        out.energy += eat;
+        out.eaten = eat; // Списывается в фазе 2: клетка принадлежит только этому боту
+        out.color = BOT_COLOR_RED; // Краснеем
+    }
+}
+
+// Движение / атака (в стену - стоим).
+// Кто победил в споре за клетку, станет известно только в фазе 2.
+template <class R>
+static void OpMove(const R&, int idx, const WorldBuffer&, BotIntent& out) {
+    int nIdx = Facing<R>(idx, out.dir);
+    if (R::bounded && nIdx < 0) return;
+    out.action = spatialIndex.Occupied(nIdx) ? ACTION_ATTACK : ACTION_MOVE;
+    out.target = nIdx;
+}
+
+// Деление только в свободную клетку; поделится ли бот, решит спор заявок в фазе 2
+template <class R>
+static void OpDivide(const R& rules, int idx, const WorldBuffer&, BotIntent& out) {
+    if (out.energy < rules.divideMinEnergy) return;
+    int nIdx = Facing<R>(idx, out.dir);
+    if (R::bounded && nIdx < 0) return;
+    if (spatialIndex.Occupied(nIdx)) return;
+    out.action = ACTION_DIVIDE;
+    out.target = nIdx;
+}
+
+// --- ЗАПРОСЫ К ОКРЕСТНОСТИ ---
+// Условие выполнено - ход продолжится с шага alt вместо next
+static void TakeBranch(int idx, const WorldBuffer& readGrid, BotIntent& out) {
+    out.ip = genomePool.Code(out.genome)[readGrid.ip[idx]].alt;
+}
+
+// В мире с краями окно обрезается краем (SpatialIndex), а не переносится
+template <class R>
+static void OpSenseCrowd(const R&, int idx, const WorldBuffer& readGrid, BotIntent& out) {
+    if (spatialIndex.BotsAround(world.X(idx), world.Y(idx), SENSE_RADIUS) >= (uint32_t)SENSE_CROWD_LIMIT) {
+        TakeBranch(idx, readGrid, out);
+    }
+}
+
+// При равенстве побеждает меньшее направление; направление, центр которого за краем, не рассматривается
+template <class R>
+static void OpSenseOrganic(const R&, int idx, const WorldBuffer&, BotIntent& out) {
+    uint32_t best = 0;
+    int bestDir = out.dir;
+    for (int d = 0; d < 8; d++) {
+        int cell = idx;
+        for (int k = 0; k < SENSE_ORGANIC_REACH && (!R::bounded || cell >= 0); k++) cell = Facing<R>(cell, d);
+        if (R::bounded && cell < 0) continue;
+        uint32_t organic = spatialIndex.OrganicAround(world.X(cell), world.Y(cell), 1);
+        if (organic > best) {
+            best = organic;
+            bestDir = d;
+        }
+    }
+    out.dir = (unsigned char)bestDir;
+}
+
+template <class R>
+static void OpSenseEnergy(const R&, int idx, const WorldBuffer& readGrid, BotIntent& out) {
+    int nIdx = Facing<R>(idx, out.dir);
+    if (R::bounded && nIdx < 0) return;
+    if (spatialIndex.Occupied(nIdx) && readGrid.energy[nIdx] > out.energy) TakeBranch(idx, readGrid, out);
+}
+
+template <class R>
+static constexpr VmOpFn<R> VM_OPS[VM_OP_COUNT] = { OpNone<R>, OpPhotosynthesis<R>, OpEat<R>, OpMove<R>, OpDivide<R>,
+                                                   OpSenseCrowd<R>, OpSenseOrganic<R>, OpSenseEnergy<R> };
+
+// Фаза 1: только чтение мира. Результат - намерение в out.
+template <class R>
+static void ProcessBotT(const R& rules, int idx, const WorldBuffer& readGrid, BotIntent& out) {
+    out.src = idx;
+    out.target = -1;
+    out.eaten = 0;
+    out.genome = readGrid.genome[idx];
+    out.op = VM_OP_NONE;
+
+    // Если бот мертв, превращаем в органику
+    if (readGrid.energy[idx] <= 0) {
+        out.action = ACTION_DIE;
+        return;
+    }
+
+    const VmStep step = genomePool.Code(out.genome)[readGrid.ip[idx]];
+    out.energy = readGrid.energy[idx];
+    out.ip = step.next;
+    out.dir = (readGrid.dir[idx] + step.turn) & 7;
+    out.color = readGrid.color[idx];
+    out.action = ACTION_STAY;
+    out.op = step.op;
+
+    VM_OPS<R>[step.op](rules, idx, readGrid, out);
+
+    out.energy -= rules.existenceCost; // Трата на существование
+}
+
+// --- SIMD: ПАЧКИ БОТОВ ---
+// Все ветки хода заменены масками: каждая дорожка берёт свой шаг из таблицы генома,
+// а результат операции выбирается по маске op. Порядок и формулы - как в скалярных Op*.
+// У умерших ботов (energy <= 0) считается всё то же, но намерение переписывается на DIE.
+
+// Переносимая пачка: сбор данных по дорожкам скалярный (на NEON нет gather),
+// арифметика - плотные циклы по массивам дорожек, которые векторизует компилятор
+template <class R>
+static void ProcessBatchLanes(const R& rules, const int* bots, const WorldBuffer& g, BotIntent* out) {
+    const int N = VM_BATCH_LANES;
+    const VmStep* code = genomePool.code.data();
+    int energy[N], slot[N], organic[N], target[N], eaten[N];
+    unsigned char dir[N], color[N], action[N], next[N], op[N];
+
+    for (int l = 0; l < N; l++) {
+        int idx = bots[l];
+        energy[l] = g.energy[idx];
+        slot[l] = g.genome[idx];
+        organic[l] = g.organic[idx];
+        const VmStep step = code[(size_t)slot[l] * genomeSize + g.ip[idx]];
+        op[l] = step.op;
+        next[l] = step.next;
+        dir[l] = (g.dir[idx] + step.turn) & 7;
+        color[l] = g.color[idx];
+    }
+
+    for (int l = 0; l < N; l++) {
+        int photo = op[l] == VM_OP_PHOTOSYNTHESIS;
+        int eat = (op[l] == VM_OP_EAT) & (organic[l] > 0);
+        eaten[l] = eat ? std::min(organic[l], (int)rules.eatCap) : 0;
+        energy[l] += (photo ? (int)rules.photosynthesis : 0) + eaten[l];
+        color[l] = photo ? (unsigned char)BOT_COLOR_GREEN : eat ? (unsigned char)BOT_COLOR_RED : color[l];
+    }
+
+    for (int l = 0; l < N; l++) {
+        int divide = (op[l] == VM_OP_DIVIDE) & (energy[l] >= (int)rules.divideMinEnergy);
+        target[l] = (op[l] == VM_OP_MOVE) | divide ? Facing<R>(bots[l], dir[l]) : -1;
+    }
+    for (int l = 0; l < N; l++) {
+        int occupied = target[l] >= 0 && g.alive[target[l]];
+        if (op[l] == VM_OP_MOVE) {
+            action[l] = occupied ? (unsigned char)ACTION_ATTACK : (unsigned char)ACTION_MOVE;
+            if (R::bounded && target[l] < 0) action[l] = ACTION_STAY; // В стену
+        } else {
+            action[l] = target[l] >= 0 && !occupied ? (unsigned char)ACTION_DIVIDE : (unsigned char)ACTION_STAY;
+            if (occupied) target[l] = -1; // Занято - деления нет
+        }
+    }
+
+    for (int l = 0; l < N; l++) {
+        BotIntent& o = out[l];
+        bool dead = g.energy[bots[l]] <= 0;
+        o.src = bots[l];
+        o.target = dead ? -1 : target[l];
+        o.energy = energy[l] - rules.existenceCost; // Трата на существование
+        o.eaten = dead ? 0 : eaten[l];
+        o.genome = slot[l];
+        o.ip = next[l];
+        o.dir = dir[l];
+        o.color = color[l];
+        o.action = dead ? (unsigned char)ACTION_DIE : action[l];
+        o.op = dead ? (unsigned char)VM_OP_NONE : op[l];
+        if (!dead && op[l] >= VM_OP_SENSE_CROWD) ProcessBotT(rules, bots[l], g, o);
+    }
+}
+
+#ifdef ALIFE_VM_AVX2
+// AVX2: 8 дорожек, данные клеток и шаги генома собираются аппаратным gather.
+// Функция собирается с target("avx2") и вызывается только если процессор это умеет.
+#define ALIFE_AVX2 __attribute__((target("avx2")))
+
+// Читает 4 байта с адреса клетки - для этого байтовые массивы дополнены SIMD_GATHER_PAD
+ALIFE_AVX2 static inline __m256i GatherBytes(const std::vector<unsigned char>& v, __m256i index) {
+    return _mm256_and_si256(_mm256_i32gather_epi32((const int*)v.data(), index, 1), _mm256_set1_epi32(0xFF));
+}
+
+// Перенос координаты через край тора: v в [-1, size]
+ALIFE_AVX2 static inline __m256i WrapAxis(__m256i v, __m256i size) {
+    const __m256i zero = _mm256_setzero_si256();
+    v = _mm256_add_epi32(v, _mm256_and_si256(_mm256_cmpgt_epi32(zero, v), size));
+    return _mm256_sub_epi32(v, _mm256_and_si256(_mm256_cmpgt_epi32(v, _mm256_sub_epi32(size, _mm256_set1_epi32(1))), size));
+}
+
+// Клетка (x, y) за краем мира w x h
+ALIFE_AVX2 static inline __m256i OffEdge(__m256i x, __m256i y, __m256i w, __m256i h) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    __m256i off = _mm256_or_si256(_mm256_cmpgt_epi32(zero, x), _mm256_cmpgt_epi32(zero, y));
+    off = _mm256_or_si256(off, _mm256_cmpgt_epi32(x, _mm256_add_epi32(w, minusOne)));
+    return _mm256_or_si256(off, _mm256_cmpgt_epi32(y, _mm256_add_epi32(h, minusOne)));
+}
+
+template <class R>
+ALIFE_AVX2 static void ProcessBatchAvx2(const R& rules, const int* bots, const WorldBuffer& g, BotIntent* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+
+    const __m256i idx = _mm256_loadu_si256((const __m256i*)bots);
+    const __m256i energy0 = _mm256_i32gather_epi32(g.energy.data(), idx, 4);
+    const __m256i slot = _mm256_i32gather_epi32(g.genome.data(), idx, 4);
+    const __m256i organic = _mm256_i32gather_epi32(g.organic.data(), idx, 4);
+    const __m256i ip = GatherBytes(g.ip, idx);
+    __m256i color = GatherBytes(g.color, idx);
+
+    const __m256i codeIndex = _mm256_add_epi32(_mm256_mullo_epi32(slot, _mm256_set1_epi32(genomeSize)), ip);
+    const __m256i step = _mm256_i32gather_epi32((const int*)genomePool.code.data(), codeIndex, 4);
+    const __m256i op = _mm256_and_si256(step, byteMask);
+    const __m256i turn = _mm256_and_si256(_mm256_srli_epi32(step, 8), byteMask);
+    const __m256i next = _mm256_and_si256(_mm256_srli_epi32(step, 16), byteMask);
+    const __m256i dir = _mm256_and_si256(_mm256_add_epi32(GatherBytes(g.dir, idx), turn), _mm256_set1_epi32(7));
+
+    const __m256i isPhoto = _mm256_cmpeq_epi32(op, _mm256_set1_epi32(VM_OP_PHOTOSYNTHESIS));
+    const __m256i isEat = _mm256_and_si256(_mm256_cmpeq_epi32(op, _mm256_set1_epi32(VM_OP_EAT)),
+                                           _mm256_cmpgt_epi32(organic, zero));
+    const __m256i isMove = _mm256_cmpeq_epi32(op, _mm256_set1_epi32(VM_OP_MOVE));
+    const __m256i isDivide = _mm256_and_si256(_mm256_cmpeq_epi32(op, _mm256_set1_epi32(VM_OP_DIVIDE)),
+                                              _mm256_cmpgt_epi32(energy0, _mm256_set1_epi32(rules.divideMinEnergy - 1)));
+    const __m256i dead = _mm256_cmpgt_epi32(one, energy0);
+
+    __m256i eaten = _mm256_and_si256(_mm256_min_epi32(organic, _mm256_set1_epi32(rules.eatCap)), isEat);
+    __m256i energy = _mm256_add_epi32(energy0, _mm256_and_si256(isPhoto, _mm256_set1_epi32(rules.photosynthesis)));
+    energy = _mm256_sub_epi32(_mm256_add_epi32(energy, eaten), _mm256_set1_epi32(rules.existenceCost));
+    color = _mm256_blendv_epi8(color, _mm256_set1_epi32(BOT_COLOR_GREEN), isPhoto);
+    color = _mm256_blendv_epi8(color, _mm256_set1_epi32(BOT_COLOR_RED), isEat);
+
+    // Соседняя клетка по направлению (тор), как WorldGeometry::Neighbor. В мире с краями клетка
+    // за краем всё равно переносится (gather читает только внутри сетки), но помечается в off
+    const __m256i dx = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)DIR_X), dir);
+    const __m256i dy = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)DIR_Y), dir);
+    __m256i neighbor;
+    __m256i off = zero;
+    if (world.pow2) {
+        const __m128i shift = _mm_cvtsi32_si128(world.shift);
+        const __m256i maskX = _mm256_set1_epi32(world.maskX);
+        const __m256i maskY = _mm256_set1_epi32(world.maskY);
+        __m256i x = _mm256_add_epi32(_mm256_and_si256(idx, maskX), dx);
+        __m256i y = _mm256_add_epi32(_mm256_srl_epi32(idx, shift), dy);
+        if (R::bounded) off = OffEdge(x, y, _mm256_set1_epi32(world.w), _mm256_set1_epi32(world.h));
+        neighbor = _mm256_or_si256(_mm256_sll_epi32(_mm256_and_si256(y, maskY), shift), _mm256_and_si256(x, maskX));
+    } else {
+        // y = idx / w через double (точен для idx < 2^30), затем поправка на округление
+        const __m256i w = _mm256_set1_epi32(world.w);
+        const __m256i h = _mm256_set1_epi32(world.h);
+        const __m256d invW = _mm256_set1_pd(1.0 / world.w);
+        __m128i yLo = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(idx)), invW));
+        __m128i yHi = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(idx, 1)), invW));
+        __m256i y = _mm256_set_m128i(yHi, yLo);
+        __m256i x = _mm256_sub_epi32(idx, _mm256_mullo_epi32(y, w));
+        __m256i under = _mm256_cmpgt_epi32(zero, x);
+        y = _mm256_add_epi32(y, under);
+        x = _mm256_add_epi32(x, _mm256_and_si256(under, w));
+        __m256i over = _mm256_cmpgt_epi32(x, _mm256_sub_epi32(w, one));
+        y = _mm256_sub_epi32(y, over);
+        x = _mm256_sub_epi32(x, _mm256_and_si256(over, w));
+        x = _mm256_add_epi32(x, dx);
+        y = _mm256_add_epi32(y, dy);
+        if (R::bounded) off = OffEdge(x, y, w, h);
+        x = WrapAxis(x, w);
+        y = WrapAxis(y, h);
+        neighbor = _mm256_add_epi32(_mm256_mullo_epi32(y, w), x);
+    }
+
+    // За краем: ни шага, ни деления (в торе off == 0)
+    const __m256i occupied = _mm256_cmpgt_epi32(GatherBytes(g.alive, neighbor), zero);
+    const __m256i moves = _mm256_andnot_si256(off, isMove);
+    const __m256i divides = _mm256_andnot_si256(off, _mm256_andnot_si256(occupied, isDivide));
+    __m256i action = _mm256_blendv_epi8(_mm256_set1_epi32(ACTION_MOVE), _mm256_set1_epi32(ACTION_ATTACK), occupied);
+    action = _mm256_and_si256(action, moves); // ACTION_STAY == 0
+    action = _mm256_or_si256(action, _mm256_and_si256(divides, _mm256_set1_epi32(ACTION_DIVIDE)));
+    action = _mm256_blendv_epi8(action, _mm256_set1_epi32(ACTION_DIE), dead);
+    __m256i target = _mm256_blendv_epi8(_mm256_set1_epi32(-1), neighbor, _mm256_andnot_si256(dead, _mm256_or_si256(moves, divides)));
+    eaten = _mm256_andnot_si256(dead, eaten);
+
+    alignas(32) int lanes[9][8];
+    _mm256_store_si256((__m256i*)lanes[0], target);
+    _mm256_store_si256((__m256i*)lanes[1], energy);
+    _mm256_store_si256((__m256i*)lanes[2], eaten);
+    _mm256_store_si256((__m256i*)lanes[3], slot);
+    _mm256_store_si256((__m256i*)lanes[4], next);
+    _mm256_store_si256((__m256i*)lanes[5], dir);
+    _mm256_store_si256((__m256i*)lanes[6], color);
+    _mm256_store_si256((__m256i*)lanes[7], action);
+    _mm256_store_si256((__m256i*)lanes[8], _mm256_andnot_si256(dead, op)); // VM_OP_NONE == 0
+    for (int l = 0; l < 8; l++) {
+        BotIntent& o = out[l];
+        o.src = bots[l];
+        o.target = lanes[0][l];
+        o.energy = lanes[1][l];
+        o.eaten = lanes[2][l];
+        o.genome = lanes[3][l];
+        o.ip = (unsigned char)lanes[4][l];
+        o.dir = (unsigned char)lanes[5][l];
+        o.color = (unsigned char)lanes[6][l];
+        o.action = (unsigned char)lanes[7][l];
+        o.op = (unsigned char)lanes[8][l];
+        if (o.op >= VM_OP_SENSE_CROWD) ProcessBotT(rules, bots[l], g, o); // Запросы - скалярно
+    }
+}
+
+#undef ALIFE_AVX2
+
+static bool HasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+const char* VmSimdKernel() {
+#ifdef ALIFE_VM_AVX2
+    if (HasAvx2()) return "avx2";
+#endif
+    return "lanes";
+}
+
+const char* VmModeName(VmMode mode) {
+    switch (mode) {
+    case VM_MODE_SIMD: return "simd";
+    case VM_MODE_CHECK: return "check";
+    default: return "scalar";
+    }
+}
+
+template <class R>
+static void RunBotsSimd(const R& rules, const int* bots, int count, const WorldBuffer& readGrid, BotIntent* out) {
+    int i = 0;
+    // gather адресует шаг 32-битным индексом: на гигантском пуле геномов - только скалярно
+    if (genomePool.code.size() <= (size_t)INT_MAX) {
+#ifdef ALIFE_VM_AVX2
+        if (HasAvx2()) {
+            for (; i + 8 <= count; i += 8) ProcessBatchAvx2(rules, bots + i, readGrid, out + i);
+        }
+#endif
+        for (; i + VM_BATCH_LANES <= count; i += VM_BATCH_LANES) ProcessBatchLanes(rules, bots + i, readGrid, out + i);
+    }
+    for (; i < count; i++) ProcessBotT(rules, bots[i], readGrid, out[i]);
+}
+
+// Сравниваются только значимые поля: у DIE остальное не читается
+static bool SameIntent(const BotIntent& a, const BotIntent& b) {
+    if (a.src != b.src || a.action != b.action || a.target != b.target || a.eaten != b.eaten || a.genome != b.genome) {
+        return false;
+    }
+    if (a.action == ACTION_DIE) return true;
+    return a.energy == b.energy && a.ip == b.ip && a.dir == b.dir && a.color == b.color && a.op == b.op;
+}
+
+// Правила - локальная копия на вызов: у RuntimeRules числа лежат в регистрах/стеке, а не
+// перечитываются из глобальной simRules в каждой дорожке
+template <class R>
+static void ProcessBotWith(int idx, const WorldBuffer& readGrid, BotIntent& out) {
+    ProcessBotT(R(simRules), idx, readGrid, out);
+}
+
+template <class R>
+static void RunBotsWith(const int* bots, int count, const WorldBuffer& readGrid, BotIntent* out) {
+    const R rules(simRules);
+    if (vmMode == VM_MODE_SCALAR) {
+        for (int i = 0; i < count; i++) ProcessBotT(rules, bots[i], readGrid, out[i]);
+        return;
+    }
+    RunBotsSimd(rules, bots, count, readGrid, out);
+    if (vmMode != VM_MODE_CHECK) return;
+
+    // Сверка: эталон пересчитывается и побеждает - мир идёт так же, как в скалярном режиме
+    for (int i = 0; i < count; i++) {
+        BotIntent expected;
+        ProcessBotT(rules, bots[i], readGrid, expected);
+        if (SameIntent(out[i], expected)) continue;
+        if (vmCheckMismatches.fetch_add(1) == 0) {
+            std::fprintf(stderr, "vm check: cell %d, simd action %d target %d energy %d, scalar action %d target %d energy %d\n",
+                         bots[i], out[i].action, out[i].target, out[i].energy,
+                         expected.action, expected.target, expected.energy);
+        }
+        out[i] = expected;
+    }
+}
+
+// --- ВЫБОР ЯДРА ПО ПРАВИЛАМ ---
+// Пресеты - полностью специализированные ядра, остальное - общее ядро своей топологии (WithRules, rules.h)
+struct VmKernel {
+    const char* name;
+    void (*processBot)(int idx, const WorldBuffer& readGrid, BotIntent& out);
+    void (*runBots)(const int* bots, int count, const WorldBuffer& readGrid, BotIntent* out);
+};
+
+static VmKernel vmKernel = { "classic", ProcessBotWith<ClassicRules<false>>, RunBotsWith<ClassicRules<false>> };
+
+void SetVmRules(const SimRules& rules, bool specialized) {
+    simRules = rules;
+    vmKernel.name = WithRules(rules, specialized, [](auto r) {
+        using R = decltype(r);
+        vmKernel.processBot = ProcessBotWith<R>;
+        vmKernel.runBots = RunBotsWith<R>;
+    });
+}
+
+const char* VmRulesKernel() { return vmKernel.name; }
+
+void ProcessBot(int idx, const WorldBuffer& readGrid, BotIntent& out) { vmKernel.processBot(idx, readGrid, out); }
+
+void RunBots(const int* bots, int count, const WorldBuffer& readGrid, BotIntent* out) {
+    vmKernel.runBots(bots, count, readGrid, out);
+}
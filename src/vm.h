@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "rules.h"
+
+// --- ГЕНОМНАЯ VM: КОМПИЛЯЦИЯ ---
+// Байты генома (упрощённый набор команд):
+//   0-7   - безусловный переход: ip += cmd
+//   10-15 - поворот на (cmd - 10) * 45 градусов
+//   20    - фотосинтез            (конец хода)
+//   30    - поедание органики     (конец хода)
+//   40    - движение / атака      (конец хода)
+//   50    - деление               (конец хода)
+//   60    - сколько ботов вокруг: >= SENSE_CROWD_LIMIT в квадрате радиуса SENSE_RADIUS - переход  (конец хода)
+//   61    - повернуться к самой богатой органикой стороне                                        (конец хода)
+//   62    - бот перед нами сильнее (энергии больше) - переход                                    (конец хода)
+//   прочее - пустая команда
+// "Переход" у условных команд: ip = позиция после команды + следующий байт генома (по модулю размера).
+// За ход выполняется не больше SimRules::commandLimit команд (rules.h).
+//
+// Переходы, повороты и пустые команды не зависят от состояния мира, а каждая команда,
+// которая от него зависит, заканчивает ход. Значит, весь ход от данного ip известен заранее:
+// итоговый поворот, завершающая команда и ip после неё. Геном компилируется в таблицу
+// таких шагов (по одному на каждый стартовый ip), и ход бота - это один lookup и один переход.
+// Новая команда, меняющая поток управления по состоянию мира, должна стать границей шага.
+enum GenomeCommand : unsigned char {
+    CMD_JUMP_END = 8,      // [0, 8)
+    CMD_TURN_FIRST = 10,   // [10, 15]
+    CMD_TURN_LAST = 15,
+    CMD_PHOTOSYNTHESIS = 20,
+    CMD_EAT = 30,
+    CMD_MOVE = 40,
+    CMD_DIVIDE = 50,
+    CMD_SENSE_CROWD = 60,
+    CMD_SENSE_ORGANIC = 61,
+    CMD_SENSE_ENERGY = 62,
+};
+
+// Запросы к окрестности идут через SpatialIndex (spatial.h) - O(1) на бота
+const int SENSE_RADIUS = 2;       // Квадрат 5x5 вокруг бота (включая его самого)
+const int SENSE_CROWD_LIMIT = 6;
+const int SENSE_ORGANIC_REACH = 2; // Органика сравнивается в квадратах 3x3 с центром в 2 клетках по каждому направлению
+
+// Завершающая операция хода
+enum VmOp : unsigned char {
+    VM_OP_NONE = 0,  // Лимит команд исчерпан без действия
+    VM_OP_PHOTOSYNTHESIS,
+    VM_OP_EAT,
+    VM_OP_MOVE,
+    VM_OP_DIVIDE,
+    VM_OP_SENSE_CROWD,   // Дальше - операции-запросы: SIMD-пачки досчитывают их скалярно
+    VM_OP_SENSE_ORGANIC,
+    VM_OP_SENSE_ENERGY,
+    VM_OP_COUNT
+};
+
+// 4 байта: SIMD-путь достаёт шаг одним 32-битным gather
+struct VmStep {
+    unsigned char op;   // VmOp
+    unsigned char turn; // Суммарный поворот до операции (0-7)
+    unsigned char next; // ip после хода
+    unsigned char alt;  // ip после хода, если условие запроса выполнено (иначе next)
+};
+
+// out - size шагов, по одному на стартовый ip; лимит команд - simRules.commandLimit
+void CompileGenome(const unsigned char* genome, int size, VmStep* out);
+
+// --- ИСПОЛНЕНИЕ ---
+// Ход бота читает только сетку и пишет намерение: что бот хочет сделать и каким станет.
+// Применяет намерения двухфазный тик в sim.cpp.
+enum BotAction : unsigned char {
+    ACTION_STAY = 0,
+    ACTION_MOVE,   // target - свободная клетка
+    ACTION_ATTACK, // target - клетка с ботом-жертвой
+    ACTION_DIE,    // кончилась энергия
+    ACTION_DIVIDE, // target - свободная клетка для потомка
+};
+
+// Деление: бот с энергией не меньше rules.divideMinEnergy заявляет свободную клетку перед собой
+// (так же, как движение). Выиграв её, платит rules.divideCost и отдаёт потомку половину остатка.
+// Потомок получает геном родителя, с вероятностью rules.mutationThreshold / 2^32 - с одним изменённым байтом.
+
+struct BotIntent {
+    int src;              // Клетка бота в начале тика
+    int target;           // Цель MOVE/ATTACK/DIVIDE
+    int energy;           // Энергия после хода (без добычи от атаки)
+    int eaten;            // Сколько органики съедено под собой
+    int genome;           // Слот генома: клетку src в фазе 2 может занять победитель атаки
+    unsigned char ip;
+    unsigned char dir;
+    unsigned char color;
+    unsigned char action; // BotAction
+    unsigned char op;     // VmOp завершающей команды (для статистики; у DIE - VM_OP_NONE)
+};
+
+// Скалярная VM - эталон. SIMD-режим исполняет ботов пачками (по 8 на AVX2, иначе
+// пачки по VM_BATCH_LANES, которые компилятор векторизует под NEON/SSE) и даёт
+// побитово тот же результат. Режим сверки гоняет оба пути и считает расхождения.
+enum VmMode : int {
+    VM_MODE_SCALAR = 0,
+    VM_MODE_SIMD = 1,
+    VM_MODE_CHECK = 2,
+};
+
+const int VM_BATCH_LANES = 16;
+
+extern VmMode vmMode;
+extern std::atomic<long long> vmCheckMismatches; // Расхождения SIMD и эталона в режиме сверки
+
+struct WorldBuffer;
+
+// Правила мира: запоминает их в simRules и выбирает ядро хода. specialized = false - общее ядро
+// (RuntimeRules) и для чисел пресета: сверка специализаций с ним, замеры. Вызывается из AllocateWorld
+void SetVmRules(const SimRules& rules, bool specialized = true);
+// Выбранное ядро: имя пресета ("classic", "scarce-bounded"...) или "generic" / "generic-bounded" (rules.h)
+const char* VmRulesKernel();
+
+void ProcessBot(int idx, const WorldBuffer& readGrid, BotIntent& out);
+// Ход для count ботов из bots[] в out[] выбранным в vmMode способом
+void RunBots(const int* bots, int count, const WorldBuffer& readGrid, BotIntent* out);
+
+const char* VmModeName(VmMode mode);
+const char* VmSimdKernel(); // "avx2" или "lanes" - чем исполняется SIMD-режим на этой машине